@@ -0,0 +1,331 @@
+// dmpv-bench: generates tips-like csvs of a few sizes and times every stage
+// on them, from the raw scan to a chart frame. the results go to stdout (or
+// --output) as json so runs can be diffed and tracked, logs go to stderr
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "chart.hpp"
+#include "chart_geometry.hpp"
+#include "cli.hpp"
+#include "groupby.hpp"
+#include "ipc.hpp"
+#include "scan.hpp"
+#include "table.hpp"
+#include "tips.hpp"
+
+namespace {
+
+struct result_t {
+    std::string name;
+    std::uint64_t rows;
+    std::uint64_t bytes;
+    double seconds; // best of the repeats
+};
+
+struct bench_options_t {
+    std::vector<std::uint64_t> sizes = {1000, 100000, 1000000, 10000000};
+    int repeat = 3;
+    bool python = false;
+    std::string data_dir = "bench_data";
+    std::string output = "-";
+};
+
+// xorshift, the same file comes out on every machine
+struct random_t {
+    std::uint64_t state = 0x9E3779B97F4A7C15;
+
+    std::uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // [0, n)
+    unsigned below(unsigned n) { return static_cast<unsigned>(next() % n); }
+};
+
+// the seaborn columns with the same kinds of values, written in big blocks.
+// an existing file of the right name is reused, the big ones take a while
+std::string generate(const bench_options_t& options, std::uint64_t rows) {
+    std::filesystem::create_directories(options.data_dir);
+    std::string path = options.data_dir + "/tips_" + std::to_string(rows) + ".csv";
+    if (std::filesystem::exists(path)) {
+        return path;
+    }
+
+    std::cerr << "bench: generating " << rows << " rows into " << path << "\n";
+    static constexpr const char *sexes[] = {"Male", "Female"};
+    static constexpr const char *yes_no[] = {"Yes", "No"};
+    static constexpr const char *days[] = {"Thur", "Fri", "Sat", "Sun"};
+    static constexpr const char *times[] = {"Lunch", "Dinner"};
+
+    std::string tmp = path + ".tmp";
+    std::FILE *file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        std::cerr << "bench: " << tmp << " couldn't be created\n";
+        std::exit(1);
+    }
+
+    random_t random;
+    std::string block = "total_bill,tip,sex,smoker,day,time,size\n";
+    char line[96];
+    for (std::uint64_t i = 0; i < rows; ++i) {
+        unsigned bill = 300 + random.below(4700);
+        unsigned tip = 100 + random.below(900);
+        int size = std::snprintf(line, sizeof(line), "%u.%02u,%u.%02u,%s,%s,%s,%s,%u\n", bill / 100, bill % 100,
+                tip / 100, tip % 100, sexes[random.below(2)], yes_no[random.below(2)], days[random.below(4)],
+                times[random.below(2)], 1 + random.below(6));
+        block.append(line, static_cast<std::size_t>(size));
+        if (block.size() >= (1 << 20)) {
+            std::fwrite(block.data(), 1, block.size(), file);
+            block.clear();
+        }
+    }
+    std::fwrite(block.data(), 1, block.size(), file);
+    std::fclose(file);
+    std::filesystem::rename(tmp, path);
+    return path;
+}
+
+template <typename F>
+double best_of(int repeat, F&& run) {
+    double best = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+void bench_dataset(const bench_options_t& options, std::uint64_t rows, std::vector<result_t>& results) {
+    std::string path = generate(options, rows);
+    std::uint64_t bytes = std::filesystem::file_size(path);
+    auto add = [&](std::string name, double seconds) {
+        results.push_back({std::move(name), rows, bytes, seconds});
+    };
+
+    load_options_t load;
+    load.input = path;
+    load.use_cache = false;
+    add("native_load", best_of(options.repeat, [&] { get_tips_native(load, nullptr); }));
+
+    load.threads = 1;
+    add("native_load_1_thread", best_of(options.repeat, [&] { get_tips_native(load, nullptr); }));
+    load.threads = 0;
+
+    load.top_n = 0;
+    add("native_load_all_rows", best_of(options.repeat, [&] { get_tips_native(load, nullptr); }));
+    load.top_n = default_top_n;
+
+    // the first run fills the cache, the rest are hits
+    load.use_cache = true;
+    get_tips(load);
+    add("cached_load", best_of(options.repeat, [&] { get_tips(load); }));
+
+    add("table_load", best_of(options.repeat, [&] { load_table(path, nullptr); }));
+
+    table_t table = load_table(path, nullptr);
+    std::vector<std::size_t> top;
+    add("top_k_100", best_of(options.repeat, [&] { top = top_rows(table, "tip", default_top_n); }));
+
+    std::vector<std::string> day = {"day"};
+    std::vector<std::string> day_time = {"day", "time"};
+    aggregate_spec_t sum = {"sum", "tip"};
+    aggregate_spec_t mean = {"mean", "total_bill"};
+    aggregate_spec_t p90 = {"p90", "tip"};
+    add("group_by_day_sum", best_of(options.repeat, [&] { group_by(table, day, {&sum, 1}); }));
+    add("group_by_day_time_mean", best_of(options.repeat, [&] { group_by(table, day_time, {&mean, 1}); }));
+    add("group_by_day_p90", best_of(options.repeat, [&] { group_by(table, day, {&p90, 1}); }));
+    add("group_by_top_k", best_of(options.repeat, [&] { group_by(table, day, {&sum, 1}, &top); }));
+
+    // a result with a group per row (up to ten million), what it costs to
+    // cross a pipe or land in shared memory and to be read back in place
+    std::uint64_t groups = std::min<std::uint64_t>(rows, 10'000'000);
+    group_result_t many;
+    many.key_columns = {"id"};
+    many.value_columns = {"sum(tip)"};
+    many.keys.resize(1);
+    many.values.resize(1);
+    for (std::uint64_t g = 0; g < groups; ++g) {
+        many.keys[0].push_back(std::to_string(g));
+        many.values[0].push_back(static_cast<double>(g) / 4);
+    }
+    many.groups = groups;
+
+    std::string frame;
+    batch_view_t batch;
+    std::string error;
+    results.push_back({"result_frame_write", groups, 0,
+            best_of(options.repeat, [&] { frame = encode_result_frame(many); })});
+    results.push_back({"result_frame_read", groups, frame.size(),
+            best_of(options.repeat, [&] { read_frame(frame, batch, error); })});
+}
+
+// what a frame costs on the cpu: building the pie mesh, filling it in
+// software and, when there's a display, submitting it through rlgl
+void bench_chart(const bench_options_t& options, std::vector<result_t>& results) {
+    constexpr int width = 1280;
+    constexpr int height = 720;
+    constexpr int frames = 100;
+
+    group_result_t result;
+    result.key_columns = {"day"};
+    result.value_columns = {"sum(tip)"};
+    result.keys = {{"Thursday", "Friday", "Saturday", "Sunday"}};
+    result.values = {{227.89, 214.95, 187.92, 195.04}};
+    result.groups = 4;
+
+    // per frame, so rows_per_s reads as frames per second
+    auto add = [&](std::string name, double seconds) {
+        results.push_back({std::move(name), 1, 0, seconds / frames});
+    };
+
+    add("chart_mesh", best_of(options.repeat, [&] {
+        for (int i = 0; i < frames; ++i) {
+            std::vector<pie_vertex_t> mesh;
+            float start = 0;
+            for (std::size_t g = 0; g < result.groups; ++g) {
+                float angle = static_cast<float>(result.values[0][g] / 825.8 * 360);
+                append_sector({start, start + angle, 255, 0, 0, 255}, 216, 0, 3, mesh);
+                start += angle;
+            }
+        }
+    }));
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, "dmpv-bench");
+    bool window = IsWindowReady();
+    chart_model_t chart = build_chart_model(result, default_colors);
+
+    std::vector<std::uint8_t> image(static_cast<std::size_t>(width) * height * 4);
+    add("chart_raster_software", best_of(options.repeat, [&] {
+        for (int i = 0; i < frames; ++i) {
+            rasterize_mesh(chart.mesh, width / 2.f, height / 2.f, image.data(), width, height);
+        }
+    }));
+
+    if (!window) {
+        std::cerr << "bench: no display, skipping chart_draw\n";
+        return;
+    }
+
+    // a full redraw every frame, what the cache saves whenever nothing changed
+    chart_cache_t cache;
+    add("chart_draw", best_of(options.repeat, [&] {
+        for (int i = 0; i < frames; ++i) {
+            cache.invalidate();
+            BeginDrawing();
+            ClearBackground(BLACK);
+            cache.draw(chart, width, height, i % 4);
+            EndDrawing();
+        }
+    }));
+    cache.unload();
+    CloseWindow();
+}
+
+void write_json(const std::vector<result_t>& results, std::ostream& out) {
+    out << "{\n  \"kernel\": \"" << delimiter_kernel() << "\",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const result_t& r = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                "%s\n    {\"name\": \"%s\", \"rows\": %llu, \"bytes\": %llu, \"seconds\": %.9g, \"mb_per_s\": %.6g, "
+                "\"rows_per_s\": %.6g}",
+                i ? "," : "", r.name.c_str(), static_cast<unsigned long long>(r.rows),
+                static_cast<unsigned long long>(r.bytes), r.seconds, r.seconds > 0 ? r.bytes / r.seconds / 1e6 : 0.0,
+                r.seconds > 0 ? r.rows / r.seconds : 0.0);
+        out << line;
+    }
+    out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+// a load that throws here is a broken setup (python missing, say), not a result
+int main(int argc, char **argv) try {
+    bench_options_t options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            options.sizes.clear();
+            for (auto &size : split_list(argv[++i])) {
+                options.sizes.push_back(std::strtoull(size.c_str(), nullptr, 10));
+            }
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--python") == 0) {
+            options.python = true;
+        } else if (std::strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc) {
+            options.data_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--sizes 1000,1000000,...] [--repeat n] [--python]\n"
+                    << "       [--data-dir bench_data] [--output file|-]\n";
+            return 1;
+        }
+    }
+
+    // stdout is the json. the loaders log to fd 1 and so does python, in a
+    // child or (embedded) in this process, so fd 1 goes to stderr from here on
+    // and the json to a copy of the real stdout
+    std::fflush(stdout);
+    int json_fd = ::dup(STDOUT_FILENO);
+    ::dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    std::vector<result_t> results;
+    for (std::uint64_t rows : options.sizes) {
+        bench_dataset(options, rows, results);
+    }
+
+    // the python script fetches the seaborn dataset itself, so this is its
+    // fixed 244 rows (plus interpreter start, pandas import and the download)
+    if (options.python) {
+        auto seconds = best_of(options.repeat, [] { get_tips_python(default_top_n, nullptr); });
+        results.push_back({"python_load", 244, 0, seconds});
+
+        // the same download, but the worker keeps it (and pandas) between runs
+        load_options_t worker_options;
+        worker_options.backend = backend_t::python_worker;
+        worker_options.input = "https://raw.githubusercontent.com/mwaskom/seaborn-data/master/tips.csv";
+        seconds = best_of(options.repeat, [&] { get_tips(worker_options); });
+        results.push_back({"python_worker_load", 244, 0, seconds});
+
+#if DMPV_EMBED_PYTHON
+        // best of includes the first call, the rest reuse the warm interpreter and data frame
+        seconds = best_of(options.repeat, [] { get_tips_python_embedded(default_top_n); });
+        results.push_back({"python_embedded_load", 244, 0, seconds});
+#endif
+    }
+
+    bench_chart(options, results);
+
+    if (options.output == "-") {
+        std::ostringstream json;
+        write_json(results, json);
+        std::FILE *out = ::fdopen(json_fd, "w");
+        bool written = out && std::fputs(json.str().c_str(), out) >= 0;
+        return out && std::fclose(out) == 0 && written ? 0 : 1;
+    }
+    std::ofstream file(options.output);
+    write_json(results, file);
+    return file ? 0 : 1;
+} catch (const load_error_t& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+}
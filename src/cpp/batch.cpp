@@ -0,0 +1,95 @@
+// dmpv-batch: runs the same load and query as the viewer and writes the
+// result out instead of charting it. never touches raylib, so it runs on
+// machines without a display or a gpu
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "cli.hpp"
+#include "output.hpp"
+#include "query.hpp"
+#include "trace.hpp"
+
+// the result to output ("-", "shm:name" or a file), the exit code
+int write_output(const group_result_t& result, output_format_t format, const std::string& output,
+        std::ostream& stdout_stream) {
+    if (output == "-") {
+        write_result(result, format, stdout_stream);
+        stdout_stream.flush();
+        return stdout_stream ? 0 : 1;
+    }
+
+    // shared memory wants the size up front, so the result is written out whole first
+    if (output.starts_with("shm:")) {
+        std::ostringstream buffer;
+        write_result(result, format, buffer);
+        if (!write_shared_memory(output.substr(4), buffer.view())) {
+            std::cerr << "output: shared memory " << output.substr(4) << " couldn't be written\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "output: " << output << " couldn't be opened for writing\n";
+        return 1;
+    }
+    write_result(result, format, file);
+    file.close();
+    if (!file) {
+        std::cerr << "output: writing " << output << " failed\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    load_options_t options;
+    output_format_t format = output_format_t::csv;
+    std::string output = "-";
+    std::string trace_path;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_load_option(argc, argv, i, options)) {
+            continue;
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc && parse_output_format(argv[i + 1])) {
+            format = *parse_output_format(argv[++i]);
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " " << load_usage << "\n"
+                    << "       [--format csv|json|binary] [--output file|shm:name|-] [--trace trace.json]\n";
+            return 1;
+        }
+    }
+
+    // the loaders log to stdout, send that to stderr so stdout is just the result
+    std::ostream stdout_stream(std::cout.rdbuf(std::cerr.rdbuf()));
+
+    group_result_t result;
+    try {
+        result = load_result(options);
+    } catch (const load_error_t& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (!trace_path.empty()) {
+        if (!trace_enabled) {
+            std::cerr << "trace: built without DMPV_TRACE, nothing was recorded\n";
+        } else if (!trace_export(trace_path)) {
+            std::cerr << "trace: " << trace_path << " couldn't be written\n";
+        }
+    }
+
+    try {
+        return write_output(result, format, output, stdout_stream);
+    } catch (const load_error_t& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
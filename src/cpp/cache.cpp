@@ -0,0 +1,180 @@
+#include "cache.hpp"
+
+#include "columnar.hpp"
+#include "mapped_file.hpp"
+#include "query.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// file layout, the header is native endian since a cache never leaves the machine:
+//
+//   cache_header_t (cache.hpp)
+//   the result as a batch (columnar.hpp), mapped and read in place
+constexpr char cache_magic[4] = {'D', 'M', 'P', 'C'};
+constexpr std::uint32_t cache_version = 3; // 3: sums kept as doubles, 2 held them narrowed to float
+
+// how much of each end of the input goes into the content hash
+constexpr std::size_t hash_sample = 64 * 1024;
+
+static_assert(sizeof(cache_header_t) % batch_alignment == 0, "the batch after the header has to stay aligned");
+
+std::uint64_t fnv1a(std::string_view data, std::uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// true when a and b describe the same input and query, batch_size aside
+bool same_source(const cache_header_t& a, const cache_header_t& b) {
+    return std::memcmp(&a, &b, offsetof(cache_header_t, batch_size)) == 0;
+}
+
+// what the input looks like right now, in the shape of a header to compare against
+std::optional<cache_header_t> describe_source(const load_options_t& options) {
+    int fd = ::open(options.input.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return std::nullopt;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    cache_header_t header = {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.source_size = static_cast<std::uint64_t>(st.st_size);
+    header.source_mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    header.top_n = options.top_n;
+
+    // hashing all of a multi-gigabyte input would cost as much as parsing it,
+    // size + mtime catch real edits and the two ends catch a same-size rewrite
+    std::string sample(hash_sample, '\0');
+    ssize_t head = ::pread(fd, sample.data(), hash_sample, 0);
+    header.source_hash = fnv1a(std::string_view(sample.data(), head > 0 ? static_cast<std::size_t>(head) : 0));
+    if (header.source_size > hash_sample) {
+        ssize_t tail = ::pread(fd, sample.data(), hash_sample, static_cast<off_t>(header.source_size - hash_sample));
+        header.source_hash = fnv1a(std::string_view(sample.data(), tail > 0 ? static_cast<std::size_t>(tail) : 0),
+                header.source_hash);
+    }
+
+    ::close(fd);
+    return header;
+}
+
+std::filesystem::path cache_dir() {
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path(xdg) / "dmpv";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "dmpv";
+    }
+    return ".dmpv_cache";
+}
+
+std::filesystem::path cache_path(const load_options_t& options) {
+    std::error_code ec;
+    std::filesystem::path source = std::filesystem::weakly_canonical(options.input, ec);
+    if (ec) {
+        source = options.input;
+    }
+
+    std::uint64_t key = fnv1a(source.string());
+    key = fnv1a(std::to_string(options.top_n), key);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return cache_dir() / name;
+}
+
+} // namespace
+
+std::optional<cache_header_t> describe_cache_source(const load_options_t& options) {
+    return describe_source(options);
+}
+
+std::optional<tips_t> load_cached_tips(const load_options_t& options, const cache_header_t& source) {
+    std::filesystem::path path = cache_path(options);
+    mapped_file file(path.string());
+    if (!file.is_open() || file.size() < sizeof(cache_header_t)) {
+        std::cout << "cache: miss\n";
+        return std::nullopt;
+    }
+
+    std::string_view data = file.view();
+    cache_header_t header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!same_source(header, source) || data.size() != sizeof(header) + header.batch_size) {
+        std::cout << "cache: stale\n";
+        return std::nullopt;
+    }
+
+    tips_t tips;
+    batch_view_t batch;
+    std::string error;
+    if (!read_batch(data.substr(sizeof(header)), batch, error) || !batch_to_tips(batch, tips, error)) {
+        std::cout << "cache: stale (" << error << ")\n";
+        return std::nullopt;
+    }
+
+    std::cout << "cache: hit " << path.string() << "\n";
+    return tips;
+}
+
+void store_cached_tips(const load_options_t& options, const cache_header_t& source, const tips_t& tips) {
+    // tips are the input as it was at the lookup, one that changed since
+    // would be cached under its new size and mtime
+    auto header = describe_source(options);
+    if (!header || !same_source(*header, source)) {
+        std::cout << "cache: not stored, " << options.input << " changed while it was read\n";
+        return;
+    }
+
+    std::string batch;
+    try {
+        batch = write_batch(to_result(tips));
+    } catch (const load_error_t& e) {
+        std::cerr << "cache: not stored, " << e.what() << "\n";
+        return;
+    }
+    header->batch_size = batch.size();
+
+    std::filesystem::path path = cache_path(options);
+    std::filesystem::path tmp = path;
+    tmp += "." + std::to_string(::getpid());
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // write next to the entry and rename over it, a reader never sees half a file
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&*header), sizeof(*header));
+        out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        if (!out) {
+            std::cerr << "cache: couldn't write " << tmp.string() << "\n";
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "cache: couldn't write " << path.string() << "\n";
+        std::filesystem::remove(tmp, ec);
+    }
+}
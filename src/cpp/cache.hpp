@@ -0,0 +1,32 @@
+#pragma once
+
+#include "tips.hpp"
+
+#include <cstdint>
+#include <optional>
+
+// on-disk cache of native results so a warm start skips parsing entirely.
+// entries live in $XDG_CACHE_HOME/dmpv (or ~/.cache/dmpv) and are keyed by
+// the input path and top_n, then checked against the input's size, mtime and
+// a hash of its first and last 64 KiB before they're trusted
+
+// the start of every entry, native endian since a cache never leaves the
+// machine. everything but batch_size also describes the input it was built from
+struct cache_header_t {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t source_size;
+    std::int64_t source_mtime; // nanoseconds
+    std::uint64_t source_hash;
+    std::uint64_t top_n;
+    std::uint64_t batch_size;
+};
+
+// the input as it is right now, nothing when it can't be opened. taken once
+// before the parse and handed to both calls below
+std::optional<cache_header_t> describe_cache_source(const load_options_t& options);
+
+std::optional<tips_t> load_cached_tips(const load_options_t& options, const cache_header_t& source);
+
+// skipped when the input no longer matches source, it changed during the parse
+void store_cached_tips(const load_options_t& options, const cache_header_t& source, const tips_t& tips);
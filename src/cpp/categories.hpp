@@ -0,0 +1,97 @@
+#pragma once
+
+#include "day.hpp"
+#include "vocabulary.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// the tips dataset's other categorical columns, defined once here for both
+// decoding and the legend
+
+enum class meal_time_t : std::uint8_t {
+    lunch,
+    dinner,
+};
+
+enum class yes_no_t : std::uint8_t {
+    yes,
+    no,
+};
+
+enum class sex_t : std::uint8_t {
+    female,
+    male,
+};
+
+constexpr std::array<std::string_view, 2> meal_time_names = {"Lunch", "Dinner"};
+constexpr std::array<std::string_view, 2> yes_no_names = {"Yes", "No"};
+constexpr std::array<std::string_view, 2> sex_names = {"Female", "Male"};
+
+constexpr vocabulary_t meal_time_vocabulary(meal_time_names, 3);
+constexpr vocabulary_t yes_no_vocabulary(yes_no_names, 2);
+constexpr vocabulary_t sex_vocabulary(sex_names, 3);
+
+constexpr std::optional<meal_time_t> parse_meal_time(std::string_view text) {
+    return parse_as<meal_time_t>(meal_time_vocabulary, text);
+}
+
+constexpr std::optional<yes_no_t> parse_yes_no(std::string_view text) {
+    return parse_as<yes_no_t>(yes_no_vocabulary, text);
+}
+
+constexpr std::optional<sex_t> parse_sex(std::string_view text) {
+    return parse_as<sex_t>(sex_vocabulary, text);
+}
+
+// "Yes" and "No" alone don't say much in a legend
+constexpr std::array<std::string_view, 2> smoker_labels = {"Smoker", "Non-smoker"};
+
+// a column whose values come from a vocabulary, and what the legend calls
+// each of them in vocabulary order, the vocabulary's own names if labels is null
+struct category_t {
+    std::string_view column;
+    const vocabulary_t *vocabulary;
+    const std::string_view *labels = nullptr;
+};
+
+constexpr std::array<category_t, 4> tips_categories = {{
+    {"day", &day_vocabulary},
+    {"time", &meal_time_vocabulary},
+    {"smoker", &yes_no_vocabulary, smoker_labels.data()},
+    {"sex", &sex_vocabulary},
+}};
+
+// the entry for column, null when its values aren't a known category
+constexpr const category_t *find_category(std::string_view column) {
+    for (const category_t& category : tips_categories) {
+        if (category.column == column) {
+            return &category;
+        }
+    }
+    return nullptr;
+}
+
+// what the legend shows for value in column: "Thur" in day is "Thursday" and
+// "No" in smoker is "Non-smoker". anything outside the table comes back as is
+constexpr std::string_view category_label(std::string_view column, std::string_view value) {
+    if (const category_t *category = find_category(column)) {
+        if (auto index = category->vocabulary->find(value)) {
+            return category->labels ? category->labels[*index] : category->vocabulary->name(*index);
+        }
+    }
+    return value;
+}
+
+static_assert(parse_meal_time("Dinner") == meal_time_t::dinner);
+static_assert(parse_yes_no("No") == yes_no_t::no);
+static_assert(parse_sex("Female") == sex_t::female);
+static_assert(!parse_sex("Fe"));
+static_assert(category_label("day", "Thur") == "Thursday");
+static_assert(category_label("smoker", "No") == "Non-smoker");
+static_assert(category_label("total_bill", "No") == "No");
+static_assert(category_label("day", "Xyz") == "Xyz");
+static_assert(find_category("time")->vocabulary == &meal_time_vocabulary);
+static_assert(!find_category("tip"));
@@ -0,0 +1,216 @@
+#include "chart.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <rlgl.h>
+
+#include "trace.hpp"
+
+namespace {
+
+constexpr float font_size = chart_font_size;
+constexpr float legend_row = 33;
+
+// longest edge a pie segment may have, in chart pixels
+constexpr float max_segment_px = 3;
+
+// vertices per rlBegin/rlEnd, well under the default batch so
+// rlCheckRenderBatchLimit only flushes when the batch is actually full
+constexpr std::size_t mesh_chunk = 3 * 1024;
+
+// how far a hovered slice sticks out
+constexpr float hover_offset = 12;
+
+// render textures don't get the window's msaa, so the cached chart is drawn
+// at twice the size and filtered down instead
+constexpr int supersample = 2;
+
+raylib::Rectangle legend_row_rect(const chart_model_t& chart, const chart_slice_t& slice) {
+    return raylib::Rectangle(chart.legend.x + 4, slice.swatch.y - 4, chart.legend.width - 8, slice.swatch.height + 8);
+}
+
+} // namespace
+
+float text_width(const Font& font, const char *text, float font_size, float spacing) {
+    if (font.glyphCount == 0 || font.baseSize == 0) {
+        return 0;
+    }
+
+    float width = 0;
+    int count = 0;
+    while (*text) {
+        int size = 0;
+        int codepoint = GetCodepointNext(text, &size);
+        int index = GetGlyphIndex(font, codepoint);
+        width += font.glyphs[index].advanceX != 0 ? font.glyphs[index].advanceX
+                                                 : font.recs[index].width + font.glyphs[index].offsetX;
+        text += size;
+        ++count;
+    }
+    float scale = font_size / static_cast<float>(font.baseSize);
+    return width * scale + static_cast<float>(std::max(count - 1, 0)) * spacing;
+}
+
+chart_model_t build_chart_model(const group_result_t& result, std::span<const Color> colors, Font font) {
+    TRACE_ZONE("build_chart_model");
+    chart_model_t chart;
+    chart.font = font;
+
+    std::vector<std::size_t> groups;
+    float total = 0;
+    float label_width = 0;
+    if (!result.values.empty()) {
+        for (std::size_t g = 0; g < result.groups; ++g) {
+            double value = result.values[0][g];
+            if (value > 0) {
+                groups.push_back(g);
+                total += static_cast<float>(value);
+            }
+        }
+    }
+
+    chart.slices.reserve(groups.size());
+    for (std::size_t g : groups) {
+        chart_slice_t slice;
+        slice.label = result.label(g);
+        label_width = std::max(label_width, text_width(font, slice.label.c_str(), font_size, label_spacing));
+        chart.slices.push_back(std::move(slice));
+    }
+
+    // room for swatch, label, a gap and "100%" at the least
+    float legend_width = std::max(216.f, 10 + 20 + 10 + label_width + 16 + text_width(font, "100%", font_size, 1) + 10);
+    chart.legend = raylib::Rectangle(10, 10, legend_width, legend_row * groups.size());
+
+    float start = 0.f;
+    float startx = chart.legend.x + 10;
+    float starty = chart.legend.y + 10;
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+        chart_slice_t& slice = chart.slices[i];
+        float value = static_cast<float>(result.values[0][groups[i]]);
+
+        float angle = (value / total) * 360.f;
+        slice.start_angle = start;
+        slice.end_angle = start + angle;
+        slice.color = colors[i % colors.size()];
+        start += angle;
+
+        pie_sector_t sector = {slice.start_angle, slice.end_angle,
+                slice.color.r, slice.color.g, slice.color.b, slice.color.a};
+        slice.mesh_begin = chart.mesh.size();
+        append_sector(sector, chart.radius, chart.inner_radius, max_segment_px, chart.mesh);
+        slice.mesh_end = chart.mesh.size();
+
+        int pct = static_cast<int>((value / total) * 100.f);
+        std::snprintf(slice.percent.data(), slice.percent.size(), "%d%%", pct);
+
+        slice.swatch = raylib::Rectangle(startx, starty, 20, 20);
+        slice.label_pos = raylib::Vector2(slice.swatch.x + slice.swatch.width + 10, slice.swatch.y);
+        float percent_width = text_width(font, slice.percent.data(), font_size, 1);
+        slice.percent_pos = raylib::Vector2(chart.legend.x + chart.legend.width - percent_width - 10, slice.swatch.y);
+        starty += slice.swatch.height + 10;
+    }
+    return chart;
+}
+
+int hit_test(const chart_model_t& chart, raylib::Vector2 center, raylib::Vector2 point) {
+    for (std::size_t i = 0; i < chart.slices.size(); ++i) {
+        if (CheckCollisionPointRec(point, legend_row_rect(chart, chart.slices[i]))) {
+            return static_cast<int>(i);
+        }
+    }
+
+    float dx = point.x - center.x;
+    float dy = point.y - center.y;
+    if (dx * dx + dy * dy > chart.radius * chart.radius) {
+        return -1;
+    }
+
+    // same convention as DrawCircleSector, 0 degrees on +x and clockwise on screen
+    float angle = std::atan2(dy, dx) * RAD2DEG;
+    if (angle < 0) {
+        angle += 360.f;
+    }
+    for (std::size_t i = 0; i < chart.slices.size(); ++i) {
+        if (angle >= chart.slices[i].start_angle && angle < chart.slices[i].end_angle) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void draw_chart(const chart_model_t& chart, raylib::Vector2 center, int hovered) {
+    // the hovered slice is the same triangles pushed outwards, the mesh is
+    // built around the origin so that's just a scale
+    std::size_t hover_begin = 0;
+    std::size_t hover_end = 0;
+    if (hovered >= 0 && static_cast<std::size_t>(hovered) < chart.slices.size()) {
+        hover_begin = chart.slices[hovered].mesh_begin;
+        hover_end = chart.slices[hovered].mesh_end;
+    }
+    float hover_scale = (chart.radius + hover_offset) / chart.radius;
+
+    for (std::size_t done = 0; done < chart.mesh.size(); done += mesh_chunk) {
+        std::size_t end = std::min(done + mesh_chunk, chart.mesh.size());
+        rlCheckRenderBatchLimit(static_cast<int>(end - done));
+        rlBegin(RL_TRIANGLES);
+        for (std::size_t i = done; i < end; ++i) {
+            const pie_vertex_t& v = chart.mesh[i];
+            float scale = (i >= hover_begin && i < hover_end) ? hover_scale : 1.f;
+            rlColor4ub(v.r, v.g, v.b, v.a);
+            rlVertex2f(center.x + v.x * scale, center.y + v.y * scale);
+        }
+        rlEnd();
+    }
+
+    chart.legend.DrawRounded(0.1, 32, WHITE);
+    if (hovered >= 0 && static_cast<std::size_t>(hovered) < chart.slices.size()) {
+        legend_row_rect(chart, chart.slices[hovered]).DrawRounded(0.3, 16, LIGHTGRAY);
+    }
+    for (auto &slice : chart.slices) {
+        slice.swatch.DrawRounded(1, 32, slice.color);
+        DrawTextEx(chart.font, slice.label.c_str(), slice.label_pos, font_size, label_spacing, BLACK);
+        DrawTextEx(chart.font, slice.percent.data(), slice.percent_pos, font_size, 1, BLACK);
+    }
+}
+
+void chart_cache_t::update(const chart_model_t& chart, int width, int height, int hovered) {
+    if (width != this->width || height != this->height || target.id == 0) {
+        unload();
+        target = LoadRenderTexture(width * supersample, height * supersample);
+        SetTextureFilter(target.texture, TEXTURE_FILTER_BILINEAR);
+        this->width = width;
+        this->height = height;
+        dirty = true;
+    }
+
+    if (dirty || hovered != this->hovered) {
+        TRACE_ZONE("chart redraw");
+        Camera2D camera = {};
+        camera.zoom = supersample;
+
+        BeginTextureMode(target);
+        ClearBackground(BLANK);
+        BeginMode2D(camera);
+        draw_chart(chart, raylib::Vector2(width / 2.f, height / 2.f), hovered);
+        EndMode2D();
+        EndTextureMode();
+
+        this->hovered = hovered;
+        dirty = false;
+    }
+}
+
+void chart_cache_t::blit() const {
+    // render textures come out upside down
+    Rectangle source = {0, 0, static_cast<float>(target.texture.width), -static_cast<float>(target.texture.height)};
+    Rectangle dest = {0, 0, static_cast<float>(width), static_cast<float>(height)};
+    DrawTexturePro(target.texture, source, dest, {0, 0}, 0, WHITE);
+}
+
+void chart_cache_t::unload() {
+    if (target.id != 0) {
+        UnloadRenderTexture(target);
+        target = {};
+    }
+}
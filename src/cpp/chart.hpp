@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Rectangle.hpp>
+#include <Vector2.hpp>
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "chart_geometry.hpp"
+#include "groupby.hpp"
+
+struct chart_slice_t {
+    float start_angle;
+    float end_angle;
+    Color color;
+
+    // this slice's triangles in chart_model_t::mesh
+    std::size_t mesh_begin;
+    std::size_t mesh_end;
+
+    std::string label;
+    std::array<char, 8> percent; // "100%", null terminated
+
+    raylib::Rectangle swatch;
+    raylib::Vector2 label_pos;
+    raylib::Vector2 percent_pos;
+};
+
+// everything the frame loop needs to draw a dataset, built once when the data
+// changes so a frame is just draw calls (no allocations, no text measuring)
+struct chart_model_t {
+    std::vector<chart_slice_t> slices;
+    raylib::Rectangle legend;
+    float radius = 216;
+    float inner_radius = 0; // > 0 draws a donut
+
+    // every sector around (0, 0), submitted as a single batch
+    std::vector<pie_vertex_t> mesh;
+
+    // what the legend is laid out and drawn with
+    Font font = {};
+};
+
+constexpr float chart_font_size = 24;
+
+// slices take these in turn
+constexpr std::array<Color, 4> default_colors = {RED, BLUE, GREEN, ORANGE};
+
+// one slice per group from the result's first value column, groups with a
+// value that can't be a slice (NaN, zero or negative) are left out. text is
+// measured on the cpu, so a font without a texture (offscreen.hpp) works too,
+// but the default font only exists once there's a window
+chart_model_t build_chart_model(const group_result_t& result, std::span<const Color> colors,
+        Font font = GetFontDefault());
+
+// like MeasureTextEx() for a single line, without needing the font's texture
+float text_width(const Font& font, const char *text, float font_size, float spacing);
+
+// spacing the legend labels are drawn with, what DrawText() uses for the default font
+constexpr float label_spacing = chart_font_size / 10;
+
+// slice under point (pie sector or legend row), -1 for none
+int hit_test(const chart_model_t& chart, raylib::Vector2 center, raylib::Vector2 point);
+
+// hovered slice gets pulled out of the pie and its legend row highlighted
+void draw_chart(const chart_model_t& chart, raylib::Vector2 center, int hovered = -1);
+
+// retained mode: the chart is drawn into a texture once and that texture is
+// blitted every frame, it's only redrawn when the data (invalidate()), the
+// window size or the hovered slice changes
+class chart_cache_t {
+public:
+    chart_cache_t() = default;
+    ~chart_cache_t() { unload(); }
+
+    chart_cache_t(const chart_cache_t&) = delete;
+    chart_cache_t& operator=(const chart_cache_t&) = delete;
+
+    void invalidate() { dirty = true; }
+
+    // redraws the texture if anything changed, can't be called from inside
+    // another BeginTextureMode()
+    void update(const chart_model_t& chart, int width, int height, int hovered);
+    // the texture at (0, 0), filtered back down to width x height
+    void blit() const;
+
+    void draw(const chart_model_t& chart, int width, int height, int hovered) {
+        update(chart, width, height, hovered);
+        blit();
+    }
+
+    // has to happen before the window (and with it the gl context) goes away
+    void unload();
+
+private:
+    RenderTexture2D target = {};
+    int width = 0;
+    int height = 0;
+    int hovered = -1;
+    bool dirty = true;
+};
@@ -0,0 +1,213 @@
+#include "chart_geometry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace {
+
+constexpr float deg2rad = std::numbers::pi_v<float> / 180.f;
+
+// past this even a huge sector doesn't get any rounder
+constexpr std::size_t max_segments = 1024;
+
+// rasterize_mesh samples per pixel along each axis
+constexpr int samples_per_axis = 2;
+
+struct point_t {
+    float x;
+    float y;
+};
+
+// std::floor and std::ceil are library calls without sse4.1, too slow per row
+int floor_int(float v) {
+    int i = static_cast<int>(v);
+    return i > v ? i - 1 : i;
+}
+
+int ceil_int(float v) {
+    int i = static_cast<int>(v);
+    return i < v ? i + 1 : i;
+}
+
+} // namespace
+
+std::size_t sector_segments(const pie_sector_t& sector, float radius, float max_segment_px) {
+    float arc = std::abs(sector.end_angle - sector.start_angle) * deg2rad * radius;
+    float segments = std::ceil(arc / std::max(max_segment_px, 0.5f));
+    return std::clamp<std::size_t>(static_cast<std::size_t>(segments), 1, max_segments);
+}
+
+void append_sector(const pie_sector_t& sector, float radius, float inner_radius, float max_segment_px,
+        std::vector<pie_vertex_t>& out) {
+    std::size_t segments = sector_segments(sector, radius, max_segment_px);
+    float step = (sector.end_angle - sector.start_angle) / static_cast<float>(segments);
+
+    auto vertex = [&](float x, float y) {
+        out.push_back({x, y, sector.r, sector.g, sector.b, sector.a});
+    };
+
+    out.reserve(out.size() + segments * (inner_radius > 0 ? 6 : 3));
+
+    float angle = sector.start_angle;
+    float c0 = std::cos(angle * deg2rad);
+    float s0 = std::sin(angle * deg2rad);
+    for (std::size_t i = 0; i < segments; ++i) {
+        float next = (i + 1 == segments) ? sector.end_angle : angle + step;
+        float c1 = std::cos(next * deg2rad);
+        float s1 = std::sin(next * deg2rad);
+
+        if (inner_radius > 0) {
+            vertex(c0 * inner_radius, s0 * inner_radius);
+            vertex(c1 * radius, s1 * radius);
+            vertex(c0 * radius, s0 * radius);
+
+            vertex(c0 * inner_radius, s0 * inner_radius);
+            vertex(c1 * inner_radius, s1 * inner_radius);
+            vertex(c1 * radius, s1 * radius);
+        } else {
+            vertex(0, 0);
+            vertex(c1 * radius, s1 * radius);
+            vertex(c0 * radius, s0 * radius);
+        }
+
+        angle = next;
+        c0 = c1;
+        s0 = s1;
+    }
+}
+
+void rasterize_mesh(std::span<const pie_vertex_t> mesh, float center_x, float center_y, std::uint8_t *rgba,
+        int width, int height) {
+    if (mesh.size() < 3 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    // only the pixels under the mesh get a sample buffer
+    float min_x = mesh[0].x, max_x = mesh[0].x, min_y = mesh[0].y, max_y = mesh[0].y;
+    for (auto &v : mesh) {
+        min_x = std::min(min_x, v.x);
+        max_x = std::max(max_x, v.x);
+        min_y = std::min(min_y, v.y);
+        max_y = std::max(max_y, v.y);
+    }
+    int x0 = std::max(0, static_cast<int>(std::floor(center_x + min_x)));
+    int x1 = std::min(width, static_cast<int>(std::ceil(center_x + max_x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(center_y + min_y)));
+    int y1 = std::min(height, static_cast<int>(std::ceil(center_y + max_y)));
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // packed rgba per sample, alpha 0 for samples no triangle covers
+    int sample_width = (x1 - x0) * samples_per_axis;
+    int sample_height = (y1 - y0) * samples_per_axis;
+    thread_local std::vector<std::uint32_t> samples;
+    samples.assign(static_cast<std::size_t>(sample_width) * sample_height, 0);
+
+    auto to_samples = [&](const pie_vertex_t& v) {
+        return point_t{(center_x + v.x - x0) * samples_per_axis, (center_y + v.y - y0) * samples_per_axis};
+    };
+
+    for (std::size_t i = 0; i + 2 < mesh.size(); i += 3) {
+        std::array<point_t, 3> corner = {to_samples(mesh[i]), to_samples(mesh[i + 1]), to_samples(mesh[i + 2])};
+        const pie_vertex_t& v = mesh[i];
+        std::uint32_t color = v.r | (v.g << 8) | (v.b << 16) | (static_cast<std::uint32_t>(v.a) << 24);
+
+        // pie triangles are long and thin, so walk rows and fill the span
+        // between the edges instead of testing every sample in the bounds
+        float top = std::min({corner[0].y, corner[1].y, corner[2].y});
+        float bottom = std::max({corner[0].y, corner[1].y, corner[2].y});
+        int sy0 = std::max(0, ceil_int(top - 0.5f));
+        int sy1 = std::min(sample_height - 1, floor_int(bottom - 0.5f));
+
+        // each edge from its upper end, so an edge two triangles share gives
+        // both the exact same x and no sample falls between them
+        struct edge_t {
+            point_t top;
+            float bottom;
+            float slope; // x per y
+        };
+        std::array<edge_t, 3> edges;
+        int edge_count = 0;
+        for (int e = 0; e < 3; ++e) {
+            point_t p = corner[e];
+            point_t q = corner[(e + 1) % 3];
+            if (p.y > q.y) {
+                std::swap(p, q);
+            }
+            if (p.y != q.y) {
+                edges[edge_count++] = {p, q.y, (q.x - p.x) / (q.y - p.y)};
+            }
+        }
+
+        for (int sy = sy0; sy <= sy1; ++sy) {
+            float y = sy + 0.5f;
+            float left = std::numeric_limits<float>::max();
+            float right = std::numeric_limits<float>::lowest();
+            for (int e = 0; e < edge_count; ++e) {
+                if (y < edges[e].top.y || y > edges[e].bottom) {
+                    continue;
+                }
+                float x = edges[e].top.x + (y - edges[e].top.y) * edges[e].slope;
+                left = std::min(left, x);
+                right = std::max(right, x);
+            }
+            if (left > right) {
+                continue;
+            }
+
+            int sx0 = std::max(0, ceil_int(left - 0.5f));
+            int sx1 = std::min(sample_width - 1, floor_int(right - 0.5f));
+            std::uint32_t *row = samples.data() + static_cast<std::size_t>(sy) * sample_width;
+            for (int sx = sx0; sx <= sx1; ++sx) {
+                row[sx] = color;
+            }
+        }
+    }
+
+    // each pixel is the average of its samples blended over what was there
+    constexpr int per_pixel = samples_per_axis * samples_per_axis;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            std::uint8_t *pixel = rgba + (static_cast<std::size_t>(y) * width + x) * 4;
+            const std::uint32_t *first = samples.data()
+                    + static_cast<std::size_t>((y - y0) * samples_per_axis) * sample_width + (x - x0) * samples_per_axis;
+
+            // almost every pixel is all background or all one opaque slice
+            bool uniform = true;
+            for (int sy = 0; sy < samples_per_axis; ++sy) {
+                for (int sx = 0; sx < samples_per_axis; ++sx) {
+                    uniform = uniform && first[sy * sample_width + sx] == first[0];
+                }
+            }
+            if (uniform && (first[0] >> 24) == 0) {
+                continue;
+            }
+            if (uniform && (first[0] >> 24) == 0xFF) {
+                for (int ch = 0; ch < 4; ++ch) {
+                    pixel[ch] = static_cast<std::uint8_t>(first[0] >> (8 * ch));
+                }
+                continue;
+            }
+
+            std::array<unsigned, 4> sum = {};
+            for (int sy = 0; sy < samples_per_axis; ++sy) {
+                for (int sx = 0; sx < samples_per_axis; ++sx) {
+                    std::uint32_t sample = first[sy * sample_width + sx];
+                    unsigned alpha = sample >> 24;
+                    for (int ch = 0; ch < 3; ++ch) {
+                        unsigned value = (sample >> (8 * ch)) & 0xFF;
+                        sum[ch] += (value * alpha + pixel[ch] * (255 - alpha)) / 255;
+                    }
+                    sum[3] += alpha + pixel[3] * (255 - alpha) / 255;
+                }
+            }
+            for (int ch = 0; ch < 4; ++ch) {
+                pixel[ch] = static_cast<std::uint8_t>(sum[ch] / per_pixel);
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// triangle list geometry for pie and donut charts, kept free of raylib so it
+// can be built (and measured) without a window
+
+struct pie_vertex_t {
+    float x;
+    float y;
+    std::uint8_t r, g, b, a;
+};
+
+struct pie_sector_t {
+    float start_angle; // degrees, 0 on +x and clockwise on screen like DrawCircleSector
+    float end_angle;
+    std::uint8_t r, g, b, a;
+};
+
+// segments follow the arc length, every segment spans at most max_segment_px
+// along the outer edge, so a sliver gets one triangle and a half pie gets a
+// few hundred instead of a fixed count each
+std::size_t sector_segments(const pie_sector_t& sector, float radius, float max_segment_px);
+
+// appends one sector around (0, 0), inner_radius > 0 makes it a donut ring.
+// winding matches raylib's own shapes so it survives backface culling
+void append_sector(const pie_sector_t& sector, float radius, float inner_radius, float max_segment_px,
+        std::vector<pie_vertex_t>& out);
+
+// software fallback for drawing a mesh: fills its triangles, moved to
+// (center_x, center_y), into a tightly packed rgba8 image of width x height.
+// each pixel takes 2x2 samples so edges come out smooth, and a sample belongs
+// to one triangle only so shared edges don't leave seams
+void rasterize_mesh(std::span<const pie_vertex_t> mesh, float center_x, float center_y, std::uint8_t *rgba,
+        int width, int height);
@@ -0,0 +1,48 @@
+#include "cli.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+std::vector<std::string> split_list(std::string_view list) {
+    std::vector<std::string> items;
+    while (!list.empty()) {
+        std::size_t comma = list.find(',');
+        items.emplace_back(list.substr(0, comma));
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    return items;
+}
+
+bool parse_load_option(int argc, char **argv, int& i, load_options_t& options) {
+    if (std::strcmp(argv[i], "--python") == 0) {
+        options.backend = backend_t::python;
+    } else if (std::strcmp(argv[i], "--python-embedded") == 0) {
+        options.backend = backend_t::python_embedded;
+    } else if (std::strcmp(argv[i], "--python-worker") == 0) {
+        options.backend = backend_t::python_worker;
+    } else if (std::strcmp(argv[i], "--worker-command") == 0 && i + 1 < argc) {
+        options.backend = backend_t::python_worker;
+        options.worker_command = argv[++i];
+    } else if (std::strcmp(argv[i], "--worker-timeout") == 0 && i + 1 < argc) {
+        options.worker_timeout = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+        options.input = argv[++i];
+    } else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+        options.top_n = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--group-by") == 0 && i + 1 < argc) {
+        options.group_by = split_list(argv[++i]);
+    } else if (std::strcmp(argv[i], "--agg") == 0 && i + 1 < argc) {
+        options.aggregate = argv[++i];
+    } else if (std::strcmp(argv[i], "--value") == 0 && i + 1 < argc) {
+        options.value = argv[++i];
+    } else if (std::strcmp(argv[i], "--order-by") == 0 && i + 1 < argc) {
+        options.order_by = argv[++i];
+    } else if (std::strcmp(argv[i], "--no-cache") == 0) {
+        options.use_cache = false;
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+        options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "tips.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the flags every front end takes, for usage messages
+constexpr std::string_view load_usage = "[--python | --python-embedded | --python-worker] [--worker-command cmd] [--worker-timeout s]\n"
+                                        "       [--input tips.csv] [--top k] [--threads n] [--no-cache]\n"
+                                        "       [--group-by col,...] [--agg sum|mean|count|min|max|pNN] [--value col] [--order-by col]";
+
+// "day,time" -> {"day", "time"}, "" -> {}
+std::vector<std::string> split_list(std::string_view list);
+
+// takes argv[i] (and its value, moving i past it) if it's one of the flags in
+// load_usage, false when it isn't
+bool parse_load_option(int argc, char **argv, int& i, load_options_t& options);
@@ -0,0 +1,260 @@
+#include "columnar.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+std::size_t aligned(std::size_t size) {
+    return (size + batch_alignment - 1) / batch_alignment * batch_alignment;
+}
+
+template <typename T>
+void put(std::string& out, std::size_t at, T value) {
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+T get(std::string_view data, std::size_t at) {
+    T value;
+    std::memcpy(&value, data.data() + at, sizeof(T));
+    return value;
+}
+
+std::size_t buffer_count(batch_type_t type) {
+    return type == batch_type_t::utf8 ? 2 : 1;
+}
+
+std::string_view column_name(std::string_view name) {
+    return name.substr(0, std::numeric_limits<std::uint8_t>::max());
+}
+
+} // namespace
+
+bool read_batch(std::string_view data, batch_view_t& batch, std::string& error) {
+    if (reinterpret_cast<std::uintptr_t>(data.data()) % batch_alignment != 0) {
+        error = "batch isn't 8-byte aligned";
+        return false;
+    }
+    if (data.size() < batch_header_size || data.substr(0, batch_magic.size()) != batch_magic) {
+        error = "not a batch";
+        return false;
+    }
+    auto version = get<std::uint16_t>(data, 4);
+    auto columns = get<std::uint16_t>(data, 6);
+    auto rows = get<std::uint64_t>(data, 8);
+    auto size = get<std::uint64_t>(data, 16);
+    if (version != batch_version) {
+        error = "unsupported batch version " + std::to_string(version);
+        return false;
+    }
+    if (size != data.size()) {
+        error = "batch says " + std::to_string(size) + " bytes, got " + std::to_string(data.size());
+        return false;
+    }
+    // every row takes at least four bytes in any column, this keeps the
+    // size arithmetic below from overflowing
+    if (columns > 0 && rows > size / 4) {
+        error = "more rows than the batch can hold";
+        return false;
+    }
+
+    batch.rows = rows;
+    batch.columns.assign(columns, {});
+
+    std::size_t at = batch_header_size;
+    std::size_t buffers = 0;
+    for (auto &column : batch.columns) {
+        if (size - at < 2) {
+            error = "truncated schema";
+            return false;
+        }
+        column.type = static_cast<batch_type_t>(get<std::uint8_t>(data, at));
+        std::size_t name_size = get<std::uint8_t>(data, at + 1);
+        if (column.type != batch_type_t::f64 && column.type != batch_type_t::utf8) {
+            error = "unknown column type " + std::to_string(static_cast<unsigned>(column.type));
+            return false;
+        }
+        if (size - at - 2 < name_size) {
+            error = "truncated schema";
+            return false;
+        }
+        column.name = data.substr(at + 2, name_size);
+        at += 2 + name_size;
+        buffers += buffer_count(column.type);
+    }
+
+    at = aligned(at);
+    if (at > size || (size - at) / 16 < buffers) {
+        error = "truncated buffer table";
+        return false;
+    }
+
+    // hands out the next buffer from the table, checked against the batch
+    auto next_buffer = [&](std::uint64_t expected, std::string_view& buffer) {
+        auto offset = get<std::uint64_t>(data, at);
+        auto length = get<std::uint64_t>(data, at + 8);
+        at += 16;
+        if (offset % batch_alignment != 0 || offset > size || length > size - offset) {
+            error = "buffer out of bounds";
+            return false;
+        }
+        if (expected != std::numeric_limits<std::uint64_t>::max() && length != expected) {
+            error = "buffer is " + std::to_string(length) + " bytes, expected " + std::to_string(expected);
+            return false;
+        }
+        buffer = data.substr(offset, length);
+        return true;
+    };
+
+    for (auto &column : batch.columns) {
+        std::string_view buffer;
+        if (column.type == batch_type_t::f64) {
+            if (!next_buffer(rows * sizeof(double), buffer)) {
+                return false;
+            }
+            column.values = {reinterpret_cast<const double *>(buffer.data()), rows};
+            continue;
+        }
+
+        if (!next_buffer((rows + 1) * sizeof(std::uint32_t), buffer)) {
+            return false;
+        }
+        column.offsets = {reinterpret_cast<const std::uint32_t *>(buffer.data()), rows + 1};
+        if (!next_buffer(std::numeric_limits<std::uint64_t>::max(), column.text)) {
+            return false;
+        }
+
+        // the one pass over the data, string() trusts these afterwards
+        if (column.offsets[0] != 0 || column.offsets[rows] != column.text.size()
+                || !std::is_sorted(column.offsets.begin(), column.offsets.end())) {
+            error = "bad offsets in column " + std::string(column.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string write_batch(const group_result_t& result) {
+    std::size_t columns = result.key_columns.size() + result.value_columns.size();
+    std::size_t rows = result.groups;
+
+    std::size_t schema_size = 0;
+    for (auto *names : {&result.key_columns, &result.value_columns}) {
+        for (auto &name : *names) {
+            schema_size += 2 + column_name(name).size();
+        }
+    }
+    std::size_t table_at = aligned(batch_header_size + schema_size);
+    std::size_t body_at = table_at + 16 * (2 * result.key_columns.size() + result.value_columns.size());
+
+    // lay the body out first so the whole batch is allocated once
+    std::vector<std::size_t> text_sizes;
+    std::size_t size = body_at;
+    for (auto &column : result.keys) {
+        std::size_t text_size = 0;
+        for (std::size_t g = 0; g < rows; ++g) {
+            text_size += column[g].size();
+        }
+        if (text_size > std::numeric_limits<std::uint32_t>::max()) {
+            throw load_error_t("batch: a key column holds more than 4 GiB of text");
+        }
+        text_sizes.push_back(text_size);
+        size += aligned((rows + 1) * sizeof(std::uint32_t)) + aligned(text_size);
+    }
+    size += result.value_columns.size() * aligned(rows * sizeof(double));
+
+    std::string out(size, '\0');
+    std::memcpy(out.data(), batch_magic.data(), batch_magic.size());
+    put(out, 4, batch_version);
+    put(out, 6, static_cast<std::uint16_t>(columns));
+    put(out, 8, static_cast<std::uint64_t>(rows));
+    put(out, 16, static_cast<std::uint64_t>(size));
+
+    std::size_t at = batch_header_size;
+    auto add_column = [&](batch_type_t type, std::string_view name) {
+        name = column_name(name);
+        put(out, at, static_cast<std::uint8_t>(type));
+        put(out, at + 1, static_cast<std::uint8_t>(name.size()));
+        std::memcpy(out.data() + at + 2, name.data(), name.size());
+        at += 2 + name.size();
+    };
+    for (auto &name : result.key_columns) {
+        add_column(batch_type_t::utf8, name);
+    }
+    for (auto &name : result.value_columns) {
+        add_column(batch_type_t::f64, name);
+    }
+
+    std::size_t table = table_at;
+    std::size_t body = body_at;
+    auto add_buffer = [&](std::size_t length) {
+        put(out, table, static_cast<std::uint64_t>(body));
+        put(out, table + 8, static_cast<std::uint64_t>(length));
+        table += 16;
+        std::size_t buffer = body;
+        body += aligned(length);
+        return buffer;
+    };
+
+    for (std::size_t k = 0; k < result.keys.size(); ++k) {
+        auto &column = result.keys[k];
+        std::size_t offsets = add_buffer((rows + 1) * sizeof(std::uint32_t));
+        std::size_t text = add_buffer(text_sizes[k]);
+
+        std::uint32_t offset = 0;
+        put(out, offsets, offset);
+        for (std::size_t g = 0; g < rows; ++g) {
+            std::memcpy(out.data() + text + offset, column[g].data(), column[g].size());
+            offset += static_cast<std::uint32_t>(column[g].size());
+            put(out, offsets + (g + 1) * sizeof(std::uint32_t), offset);
+        }
+    }
+    for (auto &column : result.values) {
+        std::size_t values = add_buffer(rows * sizeof(double));
+        std::memcpy(out.data() + values, column.data(), rows * sizeof(double));
+    }
+    return out;
+}
+
+group_result_t batch_to_result(const batch_view_t& batch) {
+    group_result_t result;
+    result.groups = batch.rows;
+    for (auto &column : batch.columns) {
+        if (column.type == batch_type_t::utf8) {
+            result.key_columns.emplace_back(column.name);
+            auto &keys = result.keys.emplace_back();
+            keys.reserve(batch.rows);
+            for (std::size_t row = 0; row < batch.rows; ++row) {
+                keys.emplace_back(column.string(row));
+            }
+        } else {
+            result.value_columns.emplace_back(column.name);
+            result.values.emplace_back(column.values.begin(), column.values.end());
+        }
+    }
+    return result;
+}
+
+bool batch_to_tips(const batch_view_t& batch, tips_t& tips, std::string& error) {
+    const column_view_t *days = nullptr;
+    const column_view_t *values = nullptr;
+    for (auto &column : batch.columns) {
+        auto &slot = column.type == batch_type_t::utf8 ? days : values;
+        if (!slot) {
+            slot = &column;
+        }
+    }
+    if (!days || !values) {
+        error = "expected a day and a tip column";
+        return false;
+    }
+
+    for (std::size_t row = 0; row < batch.rows; ++row) {
+        if (auto day = parse_day(days->string(row))) {
+            tips.set(*day, values->values[row]);
+        }
+    }
+    return true;
+}
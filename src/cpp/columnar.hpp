@@ -0,0 +1,74 @@
+#pragma once
+
+#include "groupby.hpp"
+#include "tips.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// the one format results travel in: frames from the python backends, the
+// native result cache, dmpv-batch --format binary and shared memory. it's
+// self-describing and columnar like an arrow record batch, but small enough
+// to read by hand. all integers are little endian:
+//
+//   header   "DMPB" | u16 version | u16 column count | u64 rows | u64 batch size
+//   schema   per column: u8 type | u8 name size | name, then zeros up to a multiple of 8
+//   buffers  per buffer of every column: u64 offset | u64 size (from the start of the batch)
+//   body     the buffers, each starting on a multiple of 8
+//
+// column types and their buffers:
+//
+//   f64   f64 value[rows]
+//   utf8  u32 offset[rows + 1] (offset[0] is 0) | text, row i is text[offset[i], offset[i + 1])
+//
+// a batch at an 8-byte aligned address is read in place, the column views
+// point straight into it so nothing is parsed or copied
+static_assert(std::endian::native == std::endian::little, "batches are read in place, which needs a little endian host");
+
+constexpr std::string_view batch_magic = "DMPB";
+constexpr std::uint16_t batch_version = 1;
+constexpr std::size_t batch_header_size = 24;
+constexpr std::size_t batch_alignment = 8;
+
+enum class batch_type_t : std::uint8_t {
+    f64 = 1,
+    utf8 = 2,
+};
+
+// one column of a batch_view_t, only the members for its type are set
+struct column_view_t {
+    std::string_view name;
+    batch_type_t type;
+    std::span<const double> values;          // f64
+    std::span<const std::uint32_t> offsets;  // utf8, rows + 1 of them
+    std::string_view text;                   // utf8
+
+    std::string_view string(std::size_t row) const { return text.substr(offsets[row], offsets[row + 1] - offsets[row]); }
+};
+
+// valid as long as the memory it was read from
+struct batch_view_t {
+    std::uint64_t rows = 0;
+    std::vector<column_view_t> columns;
+};
+
+// data has to be exactly one batch and 8-byte aligned, false (with the reason
+// in error) if it's short, corrupt or misaligned
+bool read_batch(std::string_view data, batch_view_t& batch, std::string& error);
+
+// key columns as utf8 followed by value columns as f64. names longer than
+// 255 bytes are cut short, a key column with more than 4 GiB of text throws
+// load_error_t
+std::string write_batch(const group_result_t& result);
+
+// utf8 columns become key columns and f64 columns value columns
+group_result_t batch_to_result(const batch_view_t& batch);
+
+// the first utf8 column as days and the first f64 column as their tips, false
+// (with the reason in error) if there's no such pair
+bool batch_to_tips(const batch_view_t& batch, tips_t& tips, std::string& error);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "scan.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// zero-copy csv tokenizer, fields point straight into the scanned buffer
+// and stay valid for as long as the buffer does.
+//
+// delimiters are found a block at a time with delimiter_mask() and then
+// walked bit by bit, so the bytes in between are never looked at one by one.
+// quoted fields may hold commas and newlines, they come back without the
+// surrounding quotes but a doubled "" inside is left as is (no copy is made)
+class csv_scanner {
+public:
+    static constexpr std::size_t max_fields = 32;
+
+    struct record_t {
+        std::array<std::string_view, max_fields> fields;
+        std::size_t count = 0;
+    };
+
+    explicit csv_scanner(std::string_view data) : data(data) {
+        if (!data.empty()) {
+            mask = delimiter_mask(data.data(), data.size());
+        }
+    }
+
+    // false once the input is exhausted, blank lines are skipped
+    bool next(record_t& record) {
+        while (pos < data.size()) {
+            read_record(record);
+            if (record.count > 1 || !record.fields[0].empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // bytes consumed so far
+    std::size_t offset() const { return pos; }
+
+private:
+    // position of the next unconsumed delimiter, data.size() if there is none
+    std::size_t next_delimiter() {
+        while (mask == 0) {
+            block += scan_block;
+            if (block >= data.size()) {
+                return data.size();
+            }
+            mask = delimiter_mask(data.data() + block, data.size() - block);
+        }
+
+        std::size_t at = block + static_cast<std::size_t>(std::countr_zero(mask));
+        mask &= mask - 1;
+        return at;
+    }
+
+    void push_field(record_t& record, std::size_t start, std::size_t end, std::size_t close_quote) {
+        std::string_view field;
+        if (close_quote != npos) {
+            field = data.substr(start + 1, close_quote - start - 1);
+        } else {
+            field = data.substr(start, end - start);
+            if (field.ends_with('\r')) {
+                field.remove_suffix(1);
+            }
+        }
+
+        if (record.count < max_fields) {
+            record.fields[record.count++] = field;
+        }
+    }
+
+    void read_record(record_t& record) {
+        record.count = 0;
+
+        std::size_t start = pos;
+        std::size_t close_quote = npos;
+        bool in_quotes = false;
+        while (true) {
+            std::size_t at = next_delimiter();
+            if (at == data.size()) {
+                push_field(record, start, at, close_quote);
+                pos = data.size();
+                return;
+            }
+
+            char c = data[at];
+            if (c == '"') {
+                if (in_quotes) {
+                    if (at + 1 < data.size() && data[at + 1] == '"') {
+                        next_delimiter(); // escaped quote, eat its partner
+                    } else {
+                        in_quotes = false;
+                        close_quote = at;
+                    }
+                } else if (at == start) {
+                    in_quotes = true;
+                }
+                continue;
+            }
+            if (in_quotes) {
+                continue;
+            }
+
+            push_field(record, start, at, close_quote);
+            start = at + 1;
+            close_quote = npos;
+
+            if (c == '\n') {
+                pos = at + 1;
+                return;
+            }
+        }
+    }
+
+    static constexpr std::size_t npos = std::string_view::npos;
+
+    std::string_view data;
+    std::size_t pos = 0;
+    std::size_t block = 0;
+    std::uint64_t mask = 0;
+};
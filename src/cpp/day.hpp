@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vocabulary.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+enum class day_t : std::uint8_t {
+    monday,
+    tuesday,
+    wednesday,
+    thursday,
+    friday,
+    saturday,
+    sunday,
+};
+
+constexpr std::size_t day_count = 7;
+
+constexpr std::array<day_t, day_count> all_days = {
+    day_t::monday, day_t::tuesday, day_t::wednesday, day_t::thursday,
+    day_t::friday, day_t::saturday, day_t::sunday,
+};
+
+// built from string literals, so .data() is null terminated and can go
+// straight to raylib
+constexpr std::array<std::string_view, day_count> day_names = {
+    "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday",
+};
+
+constexpr std::string_view day_name(day_t day) {
+    return day_names[static_cast<std::size_t>(day)];
+}
+
+constexpr vocabulary_t day_vocabulary(day_names, 3);
+
+// matches on the first three letters, so "Thur", "Thu" and "Thursday" all
+// work. runs once per csv row, see vocabulary_t for why it's cheap
+constexpr std::optional<day_t> parse_day(std::string_view text) {
+    return parse_as<day_t>(day_vocabulary, text);
+}
+
+static_assert(parse_day("Thur") == day_t::thursday);
+static_assert(parse_day("Sun") == day_t::sunday);
+static_assert(parse_day("Saturday") == day_t::saturday);
+static_assert(!parse_day("Xyz"));
+static_assert(!parse_day("Su"));
@@ -0,0 +1,325 @@
+#include "follow.hpp"
+
+#include "csv.hpp"
+#include "scan.hpp"
+#include "top_k.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// how much gets read per pread while catching up
+constexpr std::size_t read_size = 4 * 1024 * 1024;
+
+// how long a wait for the file to change can block before the stop token is
+// looked at again (and, without inotify, how often the file is checked)
+constexpr int poll_timeout_ms = 250;
+
+struct row_t {
+    double value; // the tip
+    std::uint64_t index; // byte offset of the record
+    std::optional<day_t> day;
+};
+
+using top_rows_t = top_k<row_t, kept_before>;
+
+// the streaming state of one file: where reading stopped, the partial line
+// after that and the running result
+class tips_follower_t {
+public:
+    explicit tips_follower_t(const load_options_t& options)
+            : path(options.input), top(options.top_n), all_rows(options.top_n == 0), buffer(read_size) {}
+
+    ~tips_follower_t() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    tips_follower_t(const tips_follower_t&) = delete;
+    tips_follower_t& operator=(const tips_follower_t&) = delete;
+
+    // reads everything appended since the last call (all of it the first
+    // time), true when the result changed. a stop request ends the catch-up
+    // early, the rest is read on the next call
+    bool update(load_progress_t *progress, std::stop_token stop) {
+        TRACE_ZONE("follow update");
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0) {
+            return false; // mid-rotation, pick it up when it's back
+        }
+
+        bool changed = false;
+        if (fd < 0 || info.st_ino != inode || static_cast<std::uint64_t>(info.st_size) < offset) {
+            if (!reopen()) {
+                return false;
+            }
+            changed = true;
+        }
+
+        while (!stop.stop_requested()) {
+            ssize_t count = ::pread(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+            if (count <= 0) {
+                break;
+            }
+            offset += static_cast<std::uint64_t>(count);
+            pending.append(buffer.data(), static_cast<std::size_t>(count));
+            changed |= consume();
+
+            if (progress) {
+                progress->bytes_total = std::max<std::uint64_t>(offset, info.st_size);
+                progress->bytes_parsed = offset;
+                progress->rows = rows;
+            }
+        }
+        return changed;
+    }
+
+    tips_t tips() const {
+        tips_t values;
+        for (day_t day : all_days) {
+            auto i = static_cast<std::size_t>(day);
+            if (counts[i] > 0) {
+                values.set(day, sums[i].sum);
+            }
+        }
+        return values;
+    }
+
+    std::uint64_t row_count() const { return rows; }
+    std::uint64_t unknown_days() const { return unknown; }
+
+private:
+    bool reopen() {
+        if (fd >= 0) {
+            ::close(fd);
+            std::cout << "follow: " << path << " was truncated or replaced, reading it again\n";
+        }
+
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd < 0 || ::fstat(fd, &info) != 0) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+            return false;
+        }
+
+        inode = info.st_ino;
+        offset = 0;
+        consumed = 0;
+        pending.clear();
+        columns.reset();
+        top.clear();
+        sums = {};
+        counts = {};
+        rows = 0;
+        unknown = 0;
+        return true;
+    }
+
+    void add(const row_t& row) {
+        if (!row.day) {
+            ++unknown;
+            return;
+        }
+        auto i = static_cast<std::size_t>(*row.day);
+        ++counts[i];
+        sums[i].add(row.value);
+    }
+
+    // the kept rows summed from scratch. adding rows as they get in and
+    // subtracting them as they're pushed out would carry the rounding of
+    // every row that ever passed through, and a day of appends is a lot of
+    // rows. k of them once per read is cheap next to parsing the read
+    void resum() {
+        TRACE_ZONE("follow resum");
+        sums = {};
+        counts = {};
+        unknown = 0;
+        for (auto &row : top.sorted()) { // best first, like pandas' nlargest()
+            add(row);
+        }
+    }
+
+    // parses the complete lines in pending, the partial one after them waits for more
+    bool consume() {
+        std::size_t end = pending.rfind('\n');
+        if (end == std::string::npos) {
+            return false;
+        }
+
+        // a quoted field with a newline right at the end of a read gets cut in
+        // two here, fine for the append-a-line-at-a-time files this is meant for
+        csv_scanner scanner(std::string_view(pending.data(), end + 1));
+        csv_scanner::record_t record;
+
+        if (!columns) {
+            if (!scanner.next(record)) {
+                return false;
+            }
+            auto header_begin = record.fields.begin();
+            auto header_end = header_begin + record.count;
+            auto day_col = std::find(header_begin, header_end, "day");
+            auto tip_col = std::find(header_begin, header_end, "tip");
+            if (day_col == header_end || tip_col == header_end) {
+                throw load_error_t("csv: " + path + " needs both a 'day' and a 'tip' column");
+            }
+            columns = {static_cast<std::size_t>(day_col - header_begin), static_cast<std::size_t>(tip_col - header_begin)};
+        }
+        auto [day_col, tip_col] = *columns;
+        std::size_t needed = std::max(day_col, tip_col) + 1;
+
+        bool changed = false;
+        while (true) {
+            std::uint64_t index = consumed + scanner.offset();
+            if (!scanner.next(record)) {
+                break;
+            }
+            if (record.count < needed) {
+                continue;
+            }
+
+            double tip;
+            if (!parse_decimal(record.fields[tip_col], tip)) {
+                continue;
+            }
+            ++rows;
+
+            row_t row = {tip, index, parse_day(record.fields[day_col])};
+            if (all_rows) {
+                add(row);
+                changed = true;
+                continue;
+            }
+
+            // only the top rows move the result
+            changed |= top.push(row);
+        }
+        if (changed && !all_rows) {
+            resum();
+        }
+
+        consumed += end + 1;
+        pending.erase(0, end + 1);
+        return changed;
+    }
+
+    std::string path;
+    int fd = -1;
+    ino_t inode = 0;
+    std::uint64_t offset = 0; // bytes read from the file
+    std::uint64_t consumed = 0; // bytes parsed, the file offset of pending[0]
+    std::string pending;
+    std::optional<std::pair<std::size_t, std::size_t>> columns; // day, tip
+
+    top_rows_t top;
+    bool all_rows;
+    std::array<kahan_sum_t, day_count> sums{};
+    std::array<std::uint64_t, day_count> counts{}; // rows behind each sum
+    std::uint64_t rows = 0;
+    std::uint64_t unknown = 0; // rows behind the result without a known day
+
+    std::vector<char> buffer;
+};
+
+// true when the inotify events waiting on watch touch name
+bool drain_events(int watch, std::string_view name) {
+    bool touched = false;
+    alignas(inotify_event) char events[4096];
+    while (true) {
+        ssize_t count = ::read(watch, events, sizeof(events));
+        if (count <= 0) {
+            return touched;
+        }
+        for (char *at = events; at < events + count;) {
+            auto *event = reinterpret_cast<inotify_event *>(at);
+            if (event->len > 0 && name == event->name) {
+                touched = true;
+            }
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+// an inotify fd (or -1) that's closed however follow_tips() ends, update()
+// throws on a file without the right columns
+struct watch_fd_t {
+    int fd = -1;
+
+    ~watch_fd_t() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+} // namespace
+
+void follow_tips(const load_options_t& options, load_progress_t *progress, std::stop_token stop,
+        const std::function<void(const tips_t&)>& publish) {
+    const std::string& input = options.input;
+
+    // the directory is watched rather than the file so a file that gets
+    // rotated or recreated is still seen
+    std::size_t slash = input.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : input.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? input : input.substr(slash + 1);
+
+    watch_fd_t watch = {::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)};
+    if (watch.fd >= 0
+            && ::inotify_add_watch(watch.fd, directory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO) < 0) {
+        ::close(watch.fd);
+        watch.fd = -1;
+    }
+    if (watch.fd < 0) {
+        std::cerr << "follow: can't watch " << directory << " (" << std::strerror(errno) << "), checking every "
+                << poll_timeout_ms << "ms instead\n";
+    }
+
+    // the watch is up before the first read, so nothing appended in between is missed
+    tips_follower_t follower(options);
+    bool opened = follower.update(progress, stop);
+    if (stop.stop_requested()) {
+        return; // closed mid-load
+    }
+    if (!opened) {
+        throw load_error_t("file: " + input + " couldn't be found or opened");
+    }
+    std::cout << "follow: " << follower.row_count() << " rows ok, watching " << input << "\n";
+    if (follower.unknown_days()) {
+        std::cerr << "csv: " << follower.unknown_days() << " rows had an unknown day, skipped\n";
+    }
+    publish(follower.tips());
+
+    while (!stop.stop_requested()) {
+        pollfd ready = {watch.fd, POLLIN, 0};
+        if (watch.fd >= 0 && (::poll(&ready, 1, poll_timeout_ms) <= 0 || !drain_events(watch.fd, name))) {
+            continue;
+        }
+        if (watch.fd < 0) {
+            ::poll(nullptr, 0, poll_timeout_ms);
+        }
+
+        if (follower.update(progress, stop)) {
+            publish(follower.tips());
+        }
+    }
+}
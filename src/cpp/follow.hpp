@@ -0,0 +1,17 @@
+#pragma once
+
+#include "tips.hpp"
+
+#include <functional>
+#include <stop_token>
+
+// --follow: loads options.input like get_tips_native() and then keeps
+// watching it, parsing only what gets appended and folding those rows into the
+// same top rows and per-day sums. a file that shrinks or is replaced is read
+// again from the start.
+//
+// publish is called on the calling thread once the first load is done and
+// again after every batch of appended rows that changed the result. returns
+// once stop is requested
+void follow_tips(const load_options_t& options, load_progress_t *progress, std::stop_token stop,
+        const std::function<void(const tips_t&)>& publish);
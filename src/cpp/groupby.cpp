@@ -0,0 +1,401 @@
+#include "groupby.hpp"
+
+#include "categories.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+// key spaces up to this many combinations get a flat lookup array
+constexpr std::uint64_t dense_group_limit = 1 << 20;
+
+constexpr std::uint32_t no_group = 0xFFFFFFFF;
+
+class sum_kernel : public aggregate_kernel_t {
+public:
+    void reset(std::size_t groups) override { sums.assign(groups, 0); }
+    void update(std::span<const std::uint32_t> groups, std::span<const double> values) override {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (!std::isnan(values[i])) {
+                sums[groups[i]] += values[i];
+            }
+        }
+    }
+    double result(std::size_t group) override { return sums[group]; }
+
+private:
+    std::vector<double> sums;
+};
+
+class count_kernel : public aggregate_kernel_t {
+public:
+    void reset(std::size_t groups) override { counts.assign(groups, 0); }
+    void update(std::span<const std::uint32_t> groups, std::span<const double> values) override {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (!std::isnan(values[i])) {
+                ++counts[groups[i]];
+            }
+        }
+    }
+    double result(std::size_t group) override { return static_cast<double>(counts[group]); }
+
+private:
+    std::vector<std::uint64_t> counts;
+};
+
+class mean_kernel : public aggregate_kernel_t {
+public:
+    void reset(std::size_t groups) override {
+        sum.reset(groups);
+        count.reset(groups);
+    }
+    void update(std::span<const std::uint32_t> groups, std::span<const double> values) override {
+        sum.update(groups, values);
+        count.update(groups, values);
+    }
+    double result(std::size_t group) override {
+        double n = count.result(group);
+        return n > 0 ? sum.result(group) / n : std::numeric_limits<double>::quiet_NaN();
+    }
+
+private:
+    sum_kernel sum;
+    count_kernel count;
+};
+
+template <typename Compare>
+class extreme_kernel : public aggregate_kernel_t {
+public:
+    void reset(std::size_t groups) override { best.assign(groups, std::numeric_limits<double>::quiet_NaN()); }
+    void update(std::span<const std::uint32_t> groups, std::span<const double> values) override {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            double& current = best[groups[i]];
+            if (!std::isnan(values[i]) && (std::isnan(current) || Compare{}(values[i], current))) {
+                current = values[i];
+            }
+        }
+    }
+    double result(std::size_t group) override { return best[group]; }
+
+private:
+    std::vector<double> best;
+};
+
+// linear interpolation between the two closest ranks, pandas' default
+class percentile_kernel : public aggregate_kernel_t {
+public:
+    explicit percentile_kernel(double q) : q(q) {}
+
+    void reset(std::size_t groups) override { samples.assign(groups, {}); }
+    void update(std::span<const std::uint32_t> groups, std::span<const double> values) override {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (!std::isnan(values[i])) {
+                samples[groups[i]].push_back(values[i]);
+            }
+        }
+    }
+    double result(std::size_t group) override {
+        auto &v = samples[group];
+        if (v.empty()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        double rank = q * static_cast<double>(v.size() - 1);
+        std::size_t lo = static_cast<std::size_t>(rank);
+        std::nth_element(v.begin(), v.begin() + lo, v.end());
+        double low = v[lo];
+        if (lo + 1 >= v.size()) {
+            return low;
+        }
+        double high = *std::min_element(v.begin() + lo + 1, v.end());
+        return low + (high - low) * (rank - static_cast<double>(lo));
+    }
+
+private:
+    double q;
+    std::vector<std::vector<double>> samples;
+};
+
+std::map<std::string, aggregate_factory_t, std::less<>>& registry() {
+    static std::map<std::string, aggregate_factory_t, std::less<>> factories = {
+        {"sum", [] { return std::make_unique<sum_kernel>(); }},
+        {"count", [] { return std::make_unique<count_kernel>(); }},
+        {"mean", [] { return std::make_unique<mean_kernel>(); }},
+        {"min", [] { return std::make_unique<extreme_kernel<std::less<>>>(); }},
+        {"max", [] { return std::make_unique<extreme_kernel<std::greater<>>>(); }},
+    };
+    return factories;
+}
+
+std::unique_ptr<aggregate_kernel_t> make_kernel(std::string_view kind) {
+    auto &factories = registry();
+    if (auto it = factories.find(kind); it != factories.end()) {
+        return it->second();
+    }
+
+    // "p90" and friends
+    double q;
+    if (kind.size() > 1 && kind[0] == 'p') {
+        auto [ptr, ec] = std::from_chars(kind.data() + 1, kind.data() + kind.size(), q);
+        if (ec == std::errc() && ptr == kind.data() + kind.size() && q >= 0 && q <= 100) {
+            return std::make_unique<percentile_kernel>(q / 100);
+        }
+    }
+
+    throw load_error_t("groupby: unknown aggregate '" + std::string(kind) + "'");
+}
+
+std::string format_number(double value) {
+    char buffer[32];
+    auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, ptr);
+}
+
+// dense codes for one key column, numbered in sort order of the values
+struct key_codes_t {
+    std::vector<std::uint32_t> codes; // one per selected row
+    std::vector<std::string> values;  // text of each code
+};
+
+// to_key gives what cells are hashed and compared on
+template <typename T, typename ToKey, typename Format>
+key_codes_t encode_keys(std::span<const T> cells, const std::vector<std::size_t> *rows, std::size_t count,
+        ToKey to_key, Format format) {
+    std::unordered_map<decltype(to_key(cells[0])), std::uint32_t> lookup;
+    std::vector<T> distinct;
+
+    key_codes_t out;
+    out.codes.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const T& cell = cells[rows ? (*rows)[i] : i];
+        auto [it, inserted] = lookup.try_emplace(to_key(cell), static_cast<std::uint32_t>(distinct.size()));
+        if (inserted) {
+            distinct.push_back(cell);
+        }
+        out.codes[i] = it->second;
+    }
+
+    // renumber so that code order is value order, then groups sort by code
+    std::vector<std::uint32_t> order(distinct.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return to_key(distinct[a]) < to_key(distinct[b]);
+    });
+    std::vector<std::uint32_t> rank(distinct.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        rank[order[r]] = r;
+        out.values.push_back(format(distinct[order[r]]));
+    }
+    for (auto &code : out.codes) {
+        code = rank[code];
+    }
+    return out;
+}
+
+// doubles keyed so that they hash and sort in numeric order with all NaNs
+// in one group at the end (NaN != NaN would give every NaN cell its own group)
+std::uint64_t number_key(double value) {
+    if (std::isnan(value)) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+    if (value == 0) {
+        value = 0; // -0 and 0 are one group
+    }
+    auto bits = std::bit_cast<std::uint64_t>(value);
+    return (bits & (std::uint64_t(1) << 63)) ? ~bits : bits | (std::uint64_t(1) << 63);
+}
+
+// where a text key sorts and how it comes out. a value of a known category
+// (tips_categories) goes in vocabulary order and by its full name, so days
+// are in weekday order and "Thur" is "Thursday" like the default query's
+// result has it. anything else sorts after them as written
+struct text_key_t {
+    std::size_t index = max_vocabulary_size;
+    std::string_view text;
+
+    auto operator<=>(const text_key_t&) const = default;
+};
+
+text_key_t text_key(std::string_view text, const vocabulary_t *vocabulary) {
+    if (auto index = vocabulary ? vocabulary->find(text) : std::nullopt) {
+        return {*index, vocabulary->name(*index)};
+    }
+    return {max_vocabulary_size, text};
+}
+
+// text is already dictionary coded, only the dictionary needs sorting and
+// each row's code is then a straight table lookup. spellings of one category
+// share a code, so "Thur" and "Thursday" in one file are one group
+key_codes_t encode_dictionary(const column_t& column, const std::vector<std::size_t> *rows, std::size_t count) {
+    const auto &dictionary = column.dictionary;
+    const category_t *category = find_category(column.name);
+    const vocabulary_t *vocabulary = category ? category->vocabulary : nullptr;
+    std::vector<text_key_t> sort_keys(dictionary.size());
+    for (std::size_t i = 0; i < dictionary.size(); ++i) {
+        sort_keys[i] = text_key(dictionary[i], vocabulary);
+    }
+    std::vector<std::uint32_t> order(dictionary.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return sort_keys[a] < sort_keys[b];
+    });
+
+    key_codes_t out;
+    std::vector<std::uint32_t> rank(dictionary.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        const text_key_t& key = sort_keys[order[r]];
+        if (out.values.empty() || key != sort_keys[order[r - 1]]) {
+            out.values.emplace_back(key.text);
+        }
+        rank[order[r]] = static_cast<std::uint32_t>(out.values.size() - 1);
+    }
+
+    out.codes.resize(count);
+    column.codes.visit([&](auto codes) {
+        for (std::size_t i = 0; i < count; ++i) {
+            out.codes[i] = rank[codes[rows ? (*rows)[i] : i]];
+        }
+    });
+    return out;
+}
+
+key_codes_t encode_column(const column_t& column, const std::vector<std::size_t> *rows, std::size_t count) {
+    auto same = [](const auto& v) { return v; };
+    switch (column.type) {
+        case column_type_t::integer:
+            return encode_keys(std::span<const std::int64_t>(column.integers), rows, count, same, [](std::int64_t v) { return std::to_string(v); });
+        case column_type_t::number:
+            return encode_keys(std::span<const double>(column.numbers), rows, count, number_key, format_number);
+        case column_type_t::text:
+        default:
+            return encode_dictionary(column, rows, count);
+    }
+}
+
+} // namespace
+
+void register_aggregate(std::string kind, aggregate_factory_t factory) {
+    registry()[std::move(kind)] = std::move(factory);
+}
+
+std::string group_result_t::label(std::size_t group) const {
+    if (keys.empty()) {
+        return "all";
+    }
+
+    std::string out;
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        if (k) {
+            out += ", ";
+        }
+        out += category_label(key_columns[k], keys[k][group]);
+    }
+    return out;
+}
+
+group_result_t group_by(const table_t& table, std::span<const std::string> keys,
+        std::span<const aggregate_spec_t> aggregates, const std::vector<std::size_t> *rows) {
+    TRACE_ZONE("group_by");
+    std::size_t count = rows ? rows->size() : table.rows;
+
+    // every key column to dense codes, then the codes of a row to one
+    // mixed-radix number that identifies its group
+    std::vector<key_codes_t> columns;
+    std::vector<std::uint64_t> composite(count, 0);
+    std::uint64_t radix = 1;
+    for (auto &name : keys) {
+        columns.push_back(encode_column(require_column(table, name, false), rows, count));
+        std::uint64_t cardinality = std::max<std::uint64_t>(columns.back().values.size(), 1);
+        if (radix > std::numeric_limits<std::uint64_t>::max() / cardinality) {
+            throw load_error_t("groupby: too many distinct key combinations");
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            composite[i] = composite[i] * cardinality + columns.back().codes[i];
+        }
+        radix *= cardinality;
+    }
+
+    // a small key space (any mix of days, times and flags) is a flat array
+    // indexed by the composite, only a big one needs hashing
+    std::vector<std::uint64_t> group_keys;
+    std::vector<std::uint32_t> groups(count);
+    if (radix <= dense_group_limit) {
+        std::vector<std::uint32_t> group_of(radix, no_group);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint32_t& group = group_of[composite[i]];
+            if (group == no_group) {
+                group = static_cast<std::uint32_t>(group_keys.size());
+                group_keys.push_back(composite[i]);
+            }
+            groups[i] = group;
+        }
+    } else {
+        std::unordered_map<std::uint64_t, std::uint32_t> group_of;
+        for (std::size_t i = 0; i < count; ++i) {
+            auto [it, inserted] = group_of.try_emplace(composite[i], static_cast<std::uint32_t>(group_keys.size()));
+            if (inserted) {
+                group_keys.push_back(composite[i]);
+            }
+            groups[i] = it->second;
+        }
+    }
+
+    // codes are in value order, so sorting the composites sorts the groups
+    std::vector<std::uint32_t> order(group_keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return group_keys[a] < group_keys[b];
+    });
+    std::vector<std::uint32_t> rank(group_keys.size());
+    for (std::uint32_t r = 0; r < order.size(); ++r) {
+        rank[order[r]] = r;
+    }
+    for (auto &group : groups) {
+        group = rank[group];
+    }
+
+    group_result_t result;
+    result.groups = group_keys.size();
+    result.key_columns.assign(keys.begin(), keys.end());
+    for (std::size_t k = 0; k < columns.size(); ++k) {
+        auto &keys_out = result.keys.emplace_back(result.groups);
+        for (std::size_t g = 0; g < result.groups; ++g) {
+            // peel this column's code back out of the composite
+            std::uint64_t value = group_keys[order[g]];
+            for (std::size_t j = columns.size() - 1; j > k; --j) {
+                value /= std::max<std::uint64_t>(columns[j].values.size(), 1);
+            }
+            value %= std::max<std::uint64_t>(columns[k].values.size(), 1);
+            keys_out[g] = columns[k].values[value];
+        }
+    }
+
+    std::vector<double> values(count);
+    for (auto &spec : aggregates) {
+        const column_t& column = require_column(table, spec.column, true);
+        for (std::size_t i = 0; i < count; ++i) {
+            values[i] = numeric_at(column, rows ? (*rows)[i] : i);
+        }
+
+        auto kernel = make_kernel(spec.kind);
+        kernel->reset(result.groups);
+        kernel->update(groups, values);
+
+        result.value_columns.push_back(spec.kind + "(" + spec.column + ")");
+        auto &out = result.values.emplace_back(result.groups);
+        for (std::size_t g = 0; g < result.groups; ++g) {
+            out[g] = kernel->result(g);
+        }
+    }
+    return result;
+}
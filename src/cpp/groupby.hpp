@@ -0,0 +1,57 @@
+#pragma once
+
+#include "table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// what gets computed per group: kind is "sum", "mean", "count", "min", "max",
+// "pNN" (percentile, e.g. "p90") or anything added with register_aggregate()
+struct aggregate_spec_t {
+    std::string kind;
+    std::string column;
+};
+
+// an aggregate runs over a whole column at once, one virtual call per query
+// rather than per row. NaN cells should be skipped like pandas does
+class aggregate_kernel_t {
+public:
+    virtual ~aggregate_kernel_t() = default;
+
+    // called once before update()
+    virtual void reset(std::size_t groups) = 0;
+    // groups[i] is the group values[i] belongs to
+    virtual void update(std::span<const std::uint32_t> groups, std::span<const double> values) = 0;
+    virtual double result(std::size_t group) = 0;
+};
+
+using aggregate_factory_t = std::function<std::unique_ptr<aggregate_kernel_t>()>;
+
+// makes kind usable in aggregate_spec_t, replaces a built-in of the same name
+void register_aggregate(std::string kind, aggregate_factory_t factory);
+
+// a table small enough to chart: one row per group, sorted by key (known
+// categories like days in their own order and spelled out, see
+// encode_dictionary() in groupby.cpp)
+struct group_result_t {
+    std::vector<std::string> key_columns;
+    std::vector<std::string> value_columns;       // "sum(tip)"
+    std::vector<std::vector<std::string>> keys;   // [key column][group]
+    std::vector<std::vector<double>> values;      // [value column][group]
+    std::size_t groups = 0;
+
+    // key values joined with ", ", the legend text. known categories get
+    // their display name, see category_label()
+    std::string label(std::size_t group) const;
+};
+
+// hash group-by over any number of key columns (none gives a single total).
+// rows picks a subset of the table, nullptr means every row
+group_result_t group_by(const table_t& table, std::span<const std::string> keys,
+        std::span<const aggregate_spec_t> aggregates, const std::vector<std::size_t> *rows = nullptr);
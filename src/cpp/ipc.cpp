@@ -0,0 +1,187 @@
+#include "ipc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+// slicing-by-8: table[k][b] is the crc of byte b followed by k zero bytes, so
+// eight bytes fold in with eight lookups and no dependency between them
+constexpr std::array<std::array<std::uint32_t, 256>, 8> crc_table = [] {
+    std::array<std::array<std::uint32_t, 256>, 8> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        table[0][i] = c;
+    }
+    for (std::size_t k = 1; k < 8; ++k) {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            table[k][i] = table[0][table[k - 1][i] & 0xFF] ^ (table[k - 1][i] >> 8);
+        }
+    }
+    return table;
+}();
+
+// bounds-checked little endian reader over the frame
+class reader_t {
+public:
+    explicit reader_t(std::string_view data) : data(data) {}
+
+    template <typename T>
+    bool read(T& value) {
+        if (data.size() - pos < sizeof(T)) {
+            return false;
+        }
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            bits |= std::uint64_t(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        pos += sizeof(T);
+
+        if constexpr (std::is_same_v<T, double>) {
+            value = std::bit_cast<double>(bits);
+        } else {
+            value = static_cast<T>(bits);
+        }
+        return true;
+    }
+
+    bool read(std::string_view& value, std::size_t size) {
+        if (data.size() - pos < size) {
+            return false;
+        }
+        value = data.substr(pos, size);
+        pos += size;
+        return true;
+    }
+
+    std::size_t remaining() const { return data.size() - pos; }
+
+private:
+    std::string_view data;
+    std::size_t pos = 0;
+};
+
+// little endian appender, the other end of reader_t
+class writer_t {
+public:
+    template <typename T>
+    void write(T value) {
+        std::uint64_t bits;
+        if constexpr (std::is_same_v<T, double>) {
+            bits = std::bit_cast<std::uint64_t>(value);
+        } else {
+            bits = static_cast<std::uint64_t>(value);
+        }
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            data.push_back(static_cast<char>(bits >> (8 * i)));
+        }
+    }
+
+    std::string data;
+};
+
+} // namespace
+
+std::uint32_t crc32(std::string_view data) {
+    std::uint32_t c = 0xFFFFFFFF;
+    std::size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        std::uint64_t bytes;
+        std::memcpy(&bytes, data.data() + i, sizeof(bytes)); // little endian, see columnar.hpp
+        bytes ^= c;
+        c = crc_table[7][bytes & 0xFF] ^ crc_table[6][(bytes >> 8) & 0xFF] ^ crc_table[5][(bytes >> 16) & 0xFF]
+                ^ crc_table[4][(bytes >> 24) & 0xFF] ^ crc_table[3][(bytes >> 32) & 0xFF]
+                ^ crc_table[2][(bytes >> 40) & 0xFF] ^ crc_table[1][(bytes >> 48) & 0xFF] ^ crc_table[0][bytes >> 56];
+    }
+    for (; i < data.size(); ++i) {
+        c = crc_table[0][(c ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFF;
+}
+
+namespace {
+
+// checks the header and the checksum, payload is what follows the header
+bool read_payload(std::string_view frame, std::string_view& payload, std::string& error) {
+    reader_t header(frame);
+
+    std::string_view magic;
+    std::uint16_t version, flags;
+    std::uint32_t size, checksum;
+    if (!header.read(magic, ipc_magic.size()) || !header.read(version) || !header.read(flags)
+            || !header.read(size) || !header.read(checksum)) {
+        error = "short header";
+        return false;
+    }
+    if (magic != ipc_magic) {
+        error = "bad magic";
+        return false;
+    }
+    if (version != ipc_version) {
+        error = "unsupported version " + std::to_string(version);
+        return false;
+    }
+    if (header.remaining() != size) {
+        error = "expected " + std::to_string(size) + " payload bytes, got " + std::to_string(header.remaining());
+        return false;
+    }
+
+    payload = frame.substr(ipc_header_size);
+    if (crc32(payload) != checksum) {
+        error = "checksum mismatch";
+        return false;
+    }
+    if (flags & ipc_flag_error) {
+        error = payload;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::uint32_t ipc_payload_size(std::string_view header) {
+    reader_t reader(header.substr(std::min(header.size(), std::size_t(8))));
+    std::uint32_t size = 0;
+    reader.read(size);
+    return size;
+}
+
+bool read_frame(std::string_view frame, batch_view_t& batch, std::string& error) {
+    std::string_view payload;
+    return read_payload(frame, payload, error) && read_batch(payload, batch, error);
+}
+
+bool decode_tips_frame(std::string_view frame, tips_t& values, std::string& error) {
+    batch_view_t batch;
+    return read_frame(frame, batch, error) && batch_to_tips(batch, values, error);
+}
+
+bool decode_result_frame(std::string_view frame, group_result_t& result, std::string& error) {
+    batch_view_t batch;
+    if (!read_frame(frame, batch, error)) {
+        return false;
+    }
+    result = batch_to_result(batch);
+    return true;
+}
+
+std::string encode_result_frame(const group_result_t& result) {
+    std::string payload = write_batch(result);
+
+    writer_t frame;
+    frame.data.reserve(ipc_header_size + payload.size());
+    frame.data += ipc_magic;
+    frame.write(ipc_version);
+    frame.write(std::uint16_t(0));
+    frame.write(static_cast<std::uint32_t>(payload.size()));
+    frame.write(crc32(payload));
+    frame.data += payload;
+    return frame.data;
+}
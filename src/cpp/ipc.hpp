@@ -0,0 +1,41 @@
+#pragma once
+
+#include "columnar.hpp"
+#include "groupby.hpp"
+#include "tips.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// one frame over a pipe or a socket, all integers little endian:
+//
+//   header   "DMPV" | u16 version | u16 flags | u32 payload size | u32 crc32(payload)
+//   payload  a batch (columnar.hpp), for the tips a utf8 day column and an f64 value column
+//
+// an error frame (from the python worker, see python_worker.hpp) has
+// ipc_flag_error set and the message as its payload. src/py/main.py has the
+// writing side, dmpv-batch --format binary writes the same frames.
+//
+// the payload sits 16 bytes in, so a frame at an 8-byte aligned address
+// (anything from malloc or mmap) has its batch read in place
+constexpr std::string_view ipc_magic = "DMPV";
+constexpr std::uint16_t ipc_version = 2;
+constexpr std::uint16_t ipc_flag_error = 2;
+constexpr std::size_t ipc_header_size = 16;
+
+// zlib's crc32, so python can use zlib.crc32 on its side
+std::uint32_t crc32(std::string_view data);
+
+// the payload size a frame header announces, for reading frames off a stream
+std::uint32_t ipc_payload_size(std::string_view header);
+
+// false (with the reason in error) on a short, corrupt or unknown frame, an
+// error frame's message ends up in error too. batch points into frame
+bool read_frame(std::string_view frame, batch_view_t& batch, std::string& error);
+bool decode_tips_frame(std::string_view frame, tips_t& values, std::string& error);
+bool decode_result_frame(std::string_view frame, group_result_t& result, std::string& error);
+
+// the whole frame, header included. throws like write_batch()
+std::string encode_result_frame(const group_result_t& result);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// hands the newest value from one writer thread to one reader thread, a value
+// that was never picked up is simply replaced by the next one.
+//
+// a triple buffer: the writer fills its back slot and swaps it with the middle
+// one, the reader swaps its front slot with the middle one when that holds
+// something new. each side is a single atomic exchange, neither ever waits on
+// the other and the reader's slot is never written while it's being read
+template <typename T>
+class latest_t {
+public:
+    // writer side
+    void publish(T value) {
+        slots[back] = std::move(value);
+        back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // reader side, the newest value if one came in since the last call or
+    // null. it stays valid (and untouched by the writer) until the next call
+    const T *try_take() {
+        if (!(middle.load(std::memory_order_relaxed) & fresh)) {
+            return nullptr;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+        return &slots[front];
+    }
+
+private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh = 0x4;
+
+    std::array<T, 3> slots{};
+    alignas(64) std::atomic<std::uint8_t> middle = 1;
+    alignas(64) std::uint8_t back = 0; // only touched by the writer
+    alignas(64) std::uint8_t front = 2; // only touched by the reader
+};
@@ -2,148 +2,242 @@
 #include <Text.hpp>
 #include <Vector2.hpp>
 #include <Window.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
-#include <filesystem>
-#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <future>
 #include <iostream>
 #include <raylib-cpp.hpp>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
-#include <map>
-
-const std::string filename = "tmp_DMPV_output.raw";
-using tips_t = std::map<std::string, float>;
-
-tips_t get_tips() {
-    // check if python exists
-    std::cout << "checking python3 version...\n";
-    int ret = std::system("python3 --version");
-    if (ret != 0) {
-        std::cout << "python3: bad\n";
-        std::cerr << "python3 could not be found, have you installed python?\n";
-        std::exit(ret);
-    }
 
-    std::cout << "python3: [unknown] ok\n";
-    std::system("python3 src/py/main.py"); // [FIXME] DEBUG PATH
+#include "chart.hpp"
+#include "cli.hpp"
+#include "follow.hpp"
+#include "latest.hpp"
+#include "query.hpp"
+#include "tips.hpp"
+#include "trace.hpp"
 
-    // OKAY WE GOT THE OUTPUT
+raylib::Vector2 measure_text(const std::string& text, float font_size, float spacing = 1.0f) {
+    Font font = GetFontDefault();
+    return MeasureTextEx(font, text.c_str(), font_size, spacing);
+}
 
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "file: tmp_DMPV_output.raw couldn't be found or opened\n";
-        std::exit(1);
+void draw_loading(raylib::Window& window, const load_progress_t& progress, float elapsed) {
+    raylib::Vector2 center = window.GetSize() / 2;
+    raylib::Text loading_text = {"Loading Data...", 64, BLACK, ::GetFontDefault(), 1};
+    loading_text.Draw(center - measure_text(loading_text.text, loading_text.fontSize, 1) / 2 - raylib::Vector2(0, 48));
+
+    std::uint64_t total = progress.bytes_total;
+    std::uint64_t parsed = progress.bytes_parsed;
+    std::uint64_t rows = progress.rows;
+
+    raylib::Rectangle bar(center.x - 300, center.y + 16, 600, 24);
+    bar.DrawRounded(1, 16, LIGHTGRAY);
+    if (total > 0) {
+        float done = std::min(1.f, static_cast<float>(parsed) / static_cast<float>(total));
+        raylib::Rectangle fill(bar.x, bar.y, bar.width * done, bar.height);
+        fill.DrawRounded(1, 16, BLUE);
+    } else {
+        // no idea how much is left, just bounce a block back and forth
+        float t = (std::sin(elapsed * 3.f) + 1.f) / 2.f;
+        raylib::Rectangle fill(bar.x + (bar.width - 120) * t, bar.y, 120, bar.height);
+        fill.DrawRounded(1, 16, BLUE);
     }
 
-    std::string line;
-    tips_t values;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-
-        std::string day;
-        float tip;
-        ss >> day >> tip;
-
-        if (day.starts_with("Sun")) {
-            day = "Sunday";
-        } else if (day.starts_with("Mon")) {
-            day = "Monday";
-        } else if (day.starts_with("Tue")) {
-            day = "Tuesday";
-        } else if (day.starts_with("Wed")) {
-            day = "Wednesday";
-        } else if (day.starts_with("Thu")) {
-            day = "Thursday";
-        } else if (day.starts_with("Fri")) {
-            day = "Friday";
-        } else if (day.starts_with("Sat")) {
-            day = "Saturday";
-        }
-
-        values[day] = tip;
+    char status[128];
+    if (total > 0) {
+        std::snprintf(status, sizeof(status), "%.1f / %.1f MB, %.2fM rows/s", parsed / 1e6, total / 1e6,
+                elapsed > 0 ? rows / elapsed / 1e6 : 0.0);
+    } else {
+        std::snprintf(status, sizeof(status), "waiting on backend, %.1fs", elapsed);
     }
-    file.close();
-
-    std::cout << "ipc: ok\n";
-
-    std::filesystem::remove(filename);
+    DrawText(status, center.x - MeasureText(status, 20) / 2, bar.y + bar.height + 16, 20, DARKGRAY);
+}
 
-    return values;
+// what the window shows instead of a chart when the load threw
+void draw_load_error(raylib::Window& window, const std::string& error) {
+    raylib::Vector2 center = window.GetSize() / 2;
+    raylib::Text title = {"Couldn't load data", 64, MAROON, ::GetFontDefault(), 1};
+    title.Draw(center - measure_text(title.text, title.fontSize, 1) / 2 - raylib::Vector2(0, 48));
+    DrawText(error.c_str(), center.x - MeasureText(error.c_str(), 20) / 2, center.y + 16, 20, DARKGRAY);
 }
 
-raylib::Vector2 measure_text(const std::string& text, float font_size, float spacing = 1.0f) {
-    Font font = GetFontDefault();
-    return MeasureTextEx(font, text.c_str(), font_size, spacing);
+// the last frame's phases right above the fps counter
+void draw_trace_overlay(int x, int y) {
+    static constexpr const char *phases[] = {"frame", "frame: update", "frame: draw", "frame: present"};
+    char line[64];
+    for (const char *phase : phases) {
+        y -= 22;
+        std::snprintf(line, sizeof(line), "%s %.2f ms", phase, trace_last_ms(phase));
+        DrawText(line, x, y, 20, LIME);
+    }
 }
 
 int main(int argc, char **argv) {
-    raylib::Window window(1280, 720, "dmpv", FLAG_MSAA_4X_HINT);
-    window.SetTargetFPS(60);
-    window.SetExitKey(KEY_NULL);
-
-    window.BeginDrawing();
-    window.ClearBackground(WHITE);
-    raylib::Vector2 center = window.GetSize() / 2;
-    raylib::Text loading_text = {"Loading Data...", 64, BLACK, ::GetFontDefault(), 1};
-    loading_text.Draw(center - measure_text(loading_text.text, loading_text.fontSize, 1) / 2);
-    window.EndDrawing();
+    load_options_t options;
+    bool idle = false;
+    bool follow = false;
+    std::string trace_path;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_load_option(argc, argv, i, options)) {
+            continue;
+        } else if (std::strcmp(argv[i], "--idle") == 0) {
+            idle = true;
+        } else if (std::strcmp(argv[i], "--follow") == 0) {
+            follow = true;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " " << load_usage << "\n"
+                    << "       [--idle] [--follow] [--trace trace.json]\n";
+            return 1;
+        }
+    }
 
-    tips_t tips = get_tips();
-    Color colors[] = { RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE, RED, BLUE, GREEN, ORANGE };
+    if (follow && (options.backend != backend_t::native || !is_tips_query(options))) {
+        std::cerr << "follow: only the native backend and the default query (sum of tip by day) can follow a file\n";
+        return 1;
+    }
 
-    std::cout << "loaded all\n";
+    if (!trace_path.empty() && !trace_enabled) {
+        std::cerr << "trace: built without DMPV_TRACE, nothing will be recorded\n";
+    }
 
-    while (!window.ShouldClose()) {
-        window.BeginDrawing();
-        window.ClearBackground(BLACK);
-        {
-            raylib::Vector2 center = window.GetSize() / 2;
+    raylib::Window window = [] {
+        TRACE_ZONE("window setup");
+        return raylib::Window(1280, 720, "dmpv", FLAG_MSAA_4X_HINT);
+    }();
+    window.SetTargetFPS(60);
+    window.SetExitKey(KEY_NULL);
 
-            float total = 0;
-            for (auto &[k, v] : tips) {
-                total += v;
+    // load in the background so the window keeps drawing (and answering the
+    // window manager) while a big file is parsed
+    load_progress_t progress;
+    std::future<group_result_t> loading;
+    latest_t<group_result_t> updates;
+    // before the follower, which writes them until it's joined
+    std::string follow_error;
+    std::atomic<bool> follow_failed = false; // follow_error is set
+    std::jthread follower;
+    if (follow) {
+        // the follower thread builds the result table, a frame picks up the
+        // newest one with a single atomic swap and never waits on the follower
+        follower = std::jthread([&](std::stop_token stop) {
+            try {
+                follow_tips(options, &progress, stop, [&](const tips_t& tips) { updates.publish(to_result(tips)); });
+            } catch (const load_error_t& e) {
+                follow_error = e.what();
+                follow_failed.store(true, std::memory_order_release);
             }
+        });
+    } else {
+        loading = std::async(std::launch::async, [&] {
+            return load_result(options, &progress);
+        });
+    }
+    double load_start = GetTime();
 
-            float start = 0.f;
-
-            int i = 0;
-            std::vector<std::string> labels;
-            for (auto &[k, v] : tips) {
-                labels.push_back(k);
-                float angle = (tips[k] / total) * 360.f;
+    chart_model_t chart;
+    chart_cache_t chart_cache;
+    bool loaded = false;
+    std::string load_error; // the loader threw, shown instead of the chart
+    bool overlay = false;
+    while (!window.ShouldClose()) {
+        TRACE_ZONE("frame");
+        if (trace_enabled && IsKeyPressed(KEY_F3)) {
+            overlay = !overlay;
+        }
 
-                DrawCircleSector(center, 216, start, start + angle, 
-                        256, colors[i]);
+        {
+            TRACE_ZONE("frame: update");
+            if (!follow && loading.valid() && loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                try {
+                    chart = build_chart_model(loading.get(), default_colors);
+                    chart_cache.invalidate();
+                    loaded = true;
+                    std::cout << "loaded all\n";
+                } catch (const load_error_t& e) {
+                    load_error = e.what();
+                    std::cerr << load_error << "\n";
+                }
+
+                // the chart (or the error) is static from here on, only wake up for input
+                if (idle) {
+                    EnableEventWaiting();
+                }
+            }
 
-                ++i;
+            if (follow && load_error.empty() && follow_failed.load(std::memory_order_acquire)) {
+                load_error = follow_error;
+                std::cerr << load_error << "\n";
+            }
 
-                start += angle;
+            if (const group_result_t *update = follow ? updates.try_take() : nullptr) {
+                chart = build_chart_model(*update, default_colors);
+                chart_cache.invalidate();
+                if (!loaded) {
+                    loaded = true;
+                    std::cout << "loaded all\n";
+
+                    // new rows don't wake up an event wait, so just draw less often
+                    if (idle) {
+                        window.SetTargetFPS(10);
+                    }
+                }
             }
+        }
 
-            raylib::Rectangle legend(10, 10, 216, 33 * tips.size());
-            legend.DrawRounded(0.1, 32, WHITE);
-            float startx = legend.x + 10;
-            float starty = legend.y + 10;
-            i = 0;
-            for (auto &l : labels) {
-                raylib::Rectangle color = {startx, starty, 20, 20};
-                color.DrawRounded(1, 32, colors[i]);
-                DrawText(l.c_str(), color.x + color.width + 10, color.y, 24, BLACK);
-                int pct = static_cast<int>((tips[l] / total) * 100.f);
-                std::string str = std::to_string(pct) + "%";
-                raylib::Text text(str.c_str(), 24, BLACK, ::GetFontDefault(), 1);
-                text.Draw(legend.x + legend.width - measure_text(str.c_str(), 24).x - 10, color.y);
-                ++i;
-
-                starty += color.height + 10;
+        window.BeginDrawing();
+        {
+            TRACE_ZONE("frame: draw");
+            if (!load_error.empty() && !loaded) {
+                window.ClearBackground(WHITE);
+                draw_load_error(window, load_error);
+            } else if (!loaded) {
+                window.ClearBackground(WHITE);
+                draw_loading(window, progress, static_cast<float>(GetTime() - load_start));
+            } else {
+                int hovered = hit_test(chart, window.GetSize() / 2, GetMousePosition());
+
+                window.ClearBackground(BLACK);
+                chart_cache.draw(chart, window.GetWidth(), window.GetHeight(), hovered);
             }
 
+            if (overlay) {
+                draw_trace_overlay(10, 694);
+            }
             DrawFPS(10, 694);
         }
-        window.EndDrawing();
+        {
+            // includes waiting on vsync / the fps limit
+            TRACE_ZONE("frame: present");
+            window.EndDrawing();
+        }
     }
 
+    // closed mid-load, don't sit through the rest of the file
+    progress.cancelled = true;
+    follower.request_stop();
+
+    chart_cache.unload();
     window.Close();
+
+    if (!trace_path.empty() && trace_enabled) {
+        follower = {}; // joined, so its zones are complete
+        if (trace_export(trace_path)) {
+            std::cout << "trace: wrote " << trace_path << "\n";
+        } else {
+            std::cerr << "trace: " << trace_path << " couldn't be written\n";
+        }
+    }
     return 0;
 }
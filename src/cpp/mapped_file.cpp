@@ -0,0 +1,58 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+mapped_file::mapped_file(const std::string& path) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+
+    length = static_cast<std::size_t>(st.st_size);
+    if (length == 0) {
+        return;
+    }
+
+    void *addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        length = 0;
+        return;
+    }
+
+    data = static_cast<const char *>(addr);
+    ::madvise(addr, length, MADV_SEQUENTIAL);
+}
+
+mapped_file::~mapped_file() {
+    if (data) {
+        ::munmap(const_cast<char *>(data), length);
+    }
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
+void mapped_file::release(std::size_t begin, std::size_t end) {
+    static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+    if (!data || end <= begin) {
+        return;
+    }
+
+    // clean file-backed pages, touching them again just faults them back in
+    ::madvise(const_cast<char *>(data) + begin, end - begin, MADV_DONTNEED);
+}
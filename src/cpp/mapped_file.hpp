@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// read-only mmap of a whole file, pages are faulted in on demand so the
+// resident size stays bounded by how much is touched, not by the file size
+class mapped_file {
+public:
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool is_open() const { return fd != -1; }
+    std::size_t size() const { return length; }
+    std::string_view view() const { return {data, length}; }
+
+    // tell the kernel we're done with [begin, end), only whole pages inside
+    // the range are dropped so neighbouring ranges can be released separately
+    void release(std::size_t begin, std::size_t end);
+
+private:
+    int fd = -1;
+    const char *data = nullptr;
+    std::size_t length = 0;
+};
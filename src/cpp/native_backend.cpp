@@ -0,0 +1,274 @@
+#include "tips.hpp"
+
+#include "csv.hpp"
+#include "mapped_file.hpp"
+#include "scan.hpp"
+#include "top_k.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// how far behind the cursor pages get handed back to the kernel
+constexpr std::size_t release_interval = 64 * 1024 * 1024;
+
+// how often a worker publishes its progress
+constexpr std::size_t progress_interval = 1024 * 1024;
+
+// below this a chunk isn't worth a thread
+constexpr std::size_t min_chunk_size = 1024 * 1024;
+
+struct row_t {
+    double value; // the tip
+    std::uint64_t index; // byte offset of the record, orders rows across chunks
+    std::string_view day;
+};
+
+using top_rows_t = top_k<row_t, kept_before>;
+
+// pandas sums in float64, so does this
+struct day_sums_t {
+    std::array<kahan_sum_t, day_count> sums{};
+    std::array<bool, day_count> seen{};
+    std::size_t unknown = 0;
+
+    void add(std::string_view text, double tip) {
+        auto day = parse_day(text);
+        if (!day) {
+            ++unknown;
+            return;
+        }
+        sums[static_cast<std::size_t>(*day)].add(tip);
+        seen[static_cast<std::size_t>(*day)] = true;
+    }
+
+    void merge(const day_sums_t& other) {
+        for (std::size_t i = 0; i < day_count; ++i) {
+            sums[i].merge(other.sums[i]);
+            seen[i] = seen[i] || other.seen[i];
+        }
+        unknown += other.unknown;
+    }
+};
+
+struct columns_t {
+    std::size_t day;
+    std::size_t tip;
+    std::size_t needed;
+    bool all_rows; // no top filter, sum straight away
+};
+
+// what one worker hands back: its own top rows (or with all_rows its own
+// per-day sums) and how many rows it saw
+struct partial_t {
+    top_rows_t top;
+    day_sums_t sums;
+    std::uint64_t rows = 0;
+};
+
+std::optional<std::size_t> find_column(const csv_scanner::record_t& header, std::string_view name) {
+    auto end = header.fields.begin() + header.count;
+    auto it = std::find(header.fields.begin(), end, name);
+    if (it == end) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(it - header.fields.begin());
+}
+
+void scan_chunk(mapped_file& file, std::size_t begin, std::size_t end, columns_t columns, partial_t& out,
+        load_progress_t *progress) {
+    TRACE_ZONE("scan_chunk");
+    csv_scanner scanner(file.view().substr(begin, end - begin));
+    csv_scanner::record_t record;
+
+    std::size_t released = begin;
+    std::size_t next_release = release_interval;
+    std::size_t reported = 0;
+    std::uint64_t reported_rows = 0;
+    auto report = [&] {
+        if (progress) {
+            progress->bytes_parsed += scanner.offset() - reported;
+            progress->rows += out.rows - reported_rows;
+        }
+        reported = scanner.offset();
+        reported_rows = out.rows;
+    };
+
+    while (true) {
+        std::uint64_t index = begin + scanner.offset();
+        if (!scanner.next(record)) {
+            break;
+        }
+        if (record.count < columns.needed) {
+            continue;
+        }
+
+        double tip;
+        if (!parse_decimal(record.fields[columns.tip], tip)) {
+            continue;
+        }
+        ++out.rows;
+
+        // only the current top rows are ever held, so memory doesn't grow with the file
+        if (columns.all_rows) {
+            out.sums.add(record.fields[columns.day], tip);
+        } else {
+            out.top.push({tip, index, record.fields[columns.day]});
+        }
+
+        if (scanner.offset() >= next_release) {
+            // kept rows still point into released pages, those just fault back in
+            file.release(released, begin + scanner.offset());
+            released = begin + scanner.offset();
+            next_release = scanner.offset() + release_interval;
+        }
+
+        if (scanner.offset() - reported >= progress_interval) {
+            report();
+            if (progress && progress->cancelled) {
+                return;
+            }
+        }
+    }
+    report();
+}
+
+// splits [begin, size) into up to count ranges that each start on a record.
+// a cut goes at the first newline past an even split that isn't inside a
+// quoted field. whether it is follows from how many quotes come before it,
+// those get counted one split per thread (which faults the pages in on all
+// of them too). that takes quotes to only ever wrap fields, as they do in
+// anything pandas or a spreadsheet writes
+std::vector<std::size_t> chunk_bounds(std::string_view data, std::size_t begin, unsigned count) {
+    TRACE_ZONE("chunk_bounds");
+    std::size_t length = data.size() - begin;
+    count = static_cast<unsigned>(std::clamp<std::size_t>(length / min_chunk_size, 1, count));
+    if (count == 1) {
+        return {begin, data.size()};
+    }
+
+    std::vector<std::size_t> splits(count + 1, data.size());
+    for (unsigned i = 0; i < count; ++i) {
+        splits[i] = begin + length / count * i;
+    }
+    std::vector<std::size_t> quotes(count);
+    {
+        std::vector<std::jthread> counters;
+        for (unsigned i = 0; i < count; ++i) {
+            counters.emplace_back([&, i] {
+                quotes[i] = static_cast<std::size_t>(
+                        std::count(data.begin() + splits[i], data.begin() + splits[i + 1], '"'));
+            });
+        }
+    }
+
+    std::vector<std::size_t> bounds = {begin};
+    std::size_t at = begin;
+    std::size_t quotes_before = 0;
+    bool quoted = false; // inside a quoted field at data[at]
+    for (unsigned i = 1; i < count; ++i) {
+        quotes_before += quotes[i - 1];
+        if (at < splits[i]) {
+            at = splits[i];
+            quoted = quotes_before % 2 == 1;
+        }
+        while (at < data.size()) {
+            char c = data[at++];
+            if (c == '"') {
+                quoted = !quoted;
+            } else if (c == '\n' && !quoted) {
+                break;
+            }
+        }
+        if (at > bounds.back() && at < data.size()) {
+            bounds.push_back(at);
+        }
+    }
+    bounds.push_back(data.size());
+    return bounds;
+}
+
+} // namespace
+
+tips_t get_tips_native(const load_options_t& options, load_progress_t *progress) {
+    TRACE_ZONE("get_tips_native");
+    const std::string& input = options.input;
+    std::cout << "csv: mapping " << input << "\n";
+
+    mapped_file file(input);
+    if (!file.is_open()) {
+        throw load_error_t("file: " + input + " couldn't be found or opened");
+    }
+
+    if (progress) {
+        progress->bytes_total = file.size();
+    }
+
+    std::cout << "csv: scanning with " << delimiter_kernel() << "\n";
+    csv_scanner scanner(file.view());
+    csv_scanner::record_t record;
+    if (!scanner.next(record)) {
+        throw load_error_t("csv: " + input + " is empty");
+    }
+
+    auto day_col = find_column(record, "day");
+    auto tip_col = find_column(record, "tip");
+    if (!day_col || !tip_col) {
+        throw load_error_t("csv: " + input + " needs both a 'day' and a 'tip' column");
+    }
+    columns_t columns = {*day_col, *tip_col, std::max(*day_col, *tip_col) + 1, options.top_n == 0};
+    if (progress) {
+        progress->bytes_parsed = scanner.offset();
+    }
+
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    auto bounds = chunk_bounds(file.view(), scanner.offset(), threads);
+
+    std::vector<partial_t> partials(bounds.size() - 1, partial_t{top_rows_t(options.top_n), {}, 0});
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t i = 1; i < partials.size(); ++i) {
+            workers.emplace_back(scan_chunk, std::ref(file), bounds[i], bounds[i + 1], columns, std::ref(partials[i]),
+                    progress);
+        }
+        scan_chunk(file, bounds[0], bounds[1], columns, partials[0], progress);
+    }
+
+    TRACE_ZONE("merge partials");
+    std::uint64_t rows = partials[0].rows;
+    top_rows_t& top = partials[0].top;
+    day_sums_t& sums = partials[0].sums;
+    for (std::size_t i = 1; i < partials.size(); ++i) {
+        rows += partials[i].rows;
+        top.merge(partials[i].top);
+        sums.merge(partials[i].sums);
+    }
+
+    std::cout << "csv: " << rows << " rows ok (" << partials.size() << " threads)\n";
+
+    // best first, the order pandas' nlargest() hands its groupby
+    for (auto &row : top.sorted()) {
+        sums.add(row.day, row.value);
+    }
+    if (sums.unknown) {
+        std::cerr << "csv: " << sums.unknown << " rows had an unknown day, skipped\n";
+    }
+
+    tips_t values;
+    for (day_t day : all_days) {
+        auto i = static_cast<std::size_t>(day);
+        if (sums.seen[i]) {
+            values.set(day, sums.sums[i].sum);
+        }
+    }
+    return values;
+}
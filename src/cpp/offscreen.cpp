@@ -0,0 +1,182 @@
+#include "offscreen.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+namespace {
+
+// what printable ascii needs, all a legend ever shows
+constexpr int glyph_count = 95;
+constexpr int glyph_padding = 4;
+
+// LoadFontEx() without the texture upload, which needs a gl context. the glyph
+// images are cut out of the atlas like raylib does so ImageDraw() can blend them
+Font load_cpu_font(const std::string& path, int size) {
+    int data_size = 0;
+    unsigned char *data = LoadFileData(path.c_str(), &data_size);
+    if (!data) {
+        return {};
+    }
+
+    Font font = {};
+    font.baseSize = size;
+    font.glyphCount = glyph_count;
+    font.glyphPadding = glyph_padding;
+    font.glyphs = LoadFontData(data, data_size, size, nullptr, glyph_count, FONT_DEFAULT);
+    UnloadFileData(data);
+    if (!font.glyphs) {
+        return {};
+    }
+
+    Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, glyph_count, size, glyph_padding, 0);
+    for (int i = 0; i < glyph_count; ++i) {
+        UnloadImage(font.glyphs[i].image);
+        font.glyphs[i].image = ImageFromImage(atlas, font.recs[i]);
+    }
+    UnloadImage(atlas);
+    return font;
+}
+
+// ImageDrawTextEx() measures with the font's texture, this only needs the glyph images
+void draw_text(Image& image, const Font& font, const char *text, Vector2 position, float spacing, Color color) {
+    if (font.glyphCount == 0) {
+        return;
+    }
+
+    float scale = chart_font_size / static_cast<float>(font.baseSize);
+    float x = position.x;
+    while (*text) {
+        int size = 0;
+        int codepoint = GetCodepointNext(text, &size);
+        int index = GetGlyphIndex(font, codepoint);
+        const GlyphInfo& glyph = font.glyphs[index];
+        const Rectangle& rec = font.recs[index];
+
+        if (codepoint != ' ') {
+            Rectangle source = {0, 0, static_cast<float>(glyph.image.width), static_cast<float>(glyph.image.height)};
+            Rectangle dest = {x + glyph.offsetX * scale, position.y + glyph.offsetY * scale, rec.width * scale,
+                    rec.height * scale};
+            ImageDraw(&image, glyph.image, source, dest, color);
+        }
+        x += (glyph.advanceX != 0 ? glyph.advanceX : rec.width + glyph.offsetX) * scale + spacing;
+        text += size;
+    }
+}
+
+// DrawRectangleRounded() for an image, the corner radius works out the same
+// so the legend and its swatches come out the shape they do on the gpu
+void draw_rounded(Image& image, Rectangle rec, float roundness, Color color) {
+    float radius = std::min(rec.width, rec.height) * roundness / 2;
+    ImageDrawRectangleRec(&image, {rec.x + radius, rec.y, rec.width - 2 * radius, rec.height}, color);
+    ImageDrawRectangleRec(&image, {rec.x, rec.y + radius, rec.width, rec.height - 2 * radius}, color);
+
+    int r = static_cast<int>(radius);
+    int left = static_cast<int>(rec.x + radius);
+    int right = static_cast<int>(rec.x + rec.width - radius);
+    int top = static_cast<int>(rec.y + radius);
+    int bottom = static_cast<int>(rec.y + rec.height - radius);
+    for (int x : {left, right}) {
+        for (int y : {top, bottom}) {
+            ImageDrawCircle(&image, x, y, r, color);
+        }
+    }
+}
+
+} // namespace
+
+offscreen_renderer_t::offscreen_renderer_t(int width, int height, const std::string& font_path, bool software)
+        : width(width), height(height), software(software) {
+    if (!software) {
+        SetTraceLogLevel(LOG_WARNING);
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(width, height, "dmpv");
+        window = IsWindowReady();
+        if (!window) {
+            std::cerr << "render: no display, drawing in software instead\n";
+            this->software = true;
+        }
+    }
+
+    if (font_path.empty()) {
+        // raylib's default font is only ever made into a texture, without a
+        // gl context there's nothing to draw the legend with
+        if (this->software) {
+            throw std::runtime_error("render: drawing in software needs a --font to draw the legend with");
+        }
+        text_font = GetFontDefault();
+    } else {
+        cpu_font = this->software;
+        text_font = cpu_font ? load_cpu_font(font_path, static_cast<int>(chart_font_size))
+                             : LoadFontEx(font_path.c_str(), static_cast<int>(chart_font_size), nullptr, 0);
+        if (text_font.glyphCount == 0) {
+            // the destructor won't run, the hidden window is closed here
+            if (window) {
+                CloseWindow();
+            }
+            throw std::runtime_error("font: " + font_path + " couldn't be loaded");
+        }
+    }
+
+    if (this->software) {
+        canvas = GenImageColor(width, height, BLACK);
+    } else {
+        target = LoadRenderTexture(width, height);
+    }
+}
+
+offscreen_renderer_t::~offscreen_renderer_t() {
+    if (cpu_font) {
+        UnloadFontData(text_font.glyphs, text_font.glyphCount);
+        MemFree(text_font.recs);
+    } else if (window && text_font.texture.id != GetFontDefault().texture.id) {
+        UnloadFont(text_font);
+    }
+
+    if (canvas.data) {
+        UnloadImage(canvas);
+    }
+    if (window) {
+        cache.unload();
+        UnloadRenderTexture(target);
+        CloseWindow();
+    }
+}
+
+void offscreen_renderer_t::draw_software(const chart_model_t& chart) {
+    ImageClearBackground(&canvas, BLACK);
+    rasterize_mesh(chart.mesh, width / 2.f, height / 2.f, static_cast<std::uint8_t *>(canvas.data), width, height);
+
+    // same shapes as draw_chart() in chart.cpp
+    draw_rounded(canvas, chart.legend, 0.1f, WHITE);
+    for (auto &slice : chart.slices) {
+        draw_rounded(canvas, slice.swatch, 1, slice.color);
+        draw_text(canvas, text_font, slice.label.c_str(), slice.label_pos, label_spacing, BLACK);
+        draw_text(canvas, text_font, slice.percent.data(), slice.percent_pos, 1, BLACK);
+    }
+}
+
+bool offscreen_renderer_t::render(const chart_model_t& chart, const std::string& path) {
+    TRACE_ZONE("render chart");
+    if (software) {
+        draw_software(chart);
+        return ExportImage(canvas, path.c_str());
+    }
+
+    // supersampled into the cache's texture, then filtered down into ours
+    cache.invalidate();
+    cache.update(chart, width, height, -1);
+    BeginTextureMode(target);
+    ClearBackground(BLACK);
+    cache.blit();
+    EndTextureMode();
+
+    Image image = LoadImageFromTexture(target.texture);
+    ImageFlipVertical(&image); // render textures come out upside down
+    bool ok = ExportImage(image, path.c_str());
+    UnloadImage(image);
+    return ok;
+}
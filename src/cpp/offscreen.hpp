@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+#include "chart.hpp"
+
+// draws charts into png files without anything showing up on screen.
+//
+// with a display it opens a hidden window and renders on the gpu through
+// chart_cache_t, the same path the viewer takes. without one (or when asked
+// to) the pie goes through rasterize_mesh() and the legend through raylib's
+// cpu image functions instead. either way the render targets and the font
+// atlas are made once and reused for every chart
+class offscreen_renderer_t {
+public:
+    // an empty font_path means the default font, which only exists on the
+    // gpu. throws std::runtime_error for a font that can't be loaded, or no
+    // font in software mode (asked for or fallen back to)
+    offscreen_renderer_t(int width, int height, const std::string& font_path, bool software);
+    ~offscreen_renderer_t();
+
+    offscreen_renderer_t(const offscreen_renderer_t&) = delete;
+    offscreen_renderer_t& operator=(const offscreen_renderer_t&) = delete;
+
+    bool is_software() const { return software; }
+
+    // what chart models should be built with
+    const Font& font() const { return text_font; }
+
+    // false if the png couldn't be written
+    bool render(const chart_model_t& chart, const std::string& path);
+
+private:
+    void draw_software(const chart_model_t& chart);
+
+    int width;
+    int height;
+    bool software;
+    bool window = false;
+    bool cpu_font = false; // loaded by load_cpu_font(), no texture to unload
+
+    Font text_font = {};
+
+    // gpu
+    chart_cache_t cache;
+    RenderTexture2D target = {};
+
+    // software
+    Image canvas = {};
+};
@@ -0,0 +1,171 @@
+#include "output.hpp"
+
+#include "ipc.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+void write_number(std::ostream& out, double value) {
+    char text[32];
+    auto [end, ec] = std::to_chars(text, text + sizeof(text), value);
+    out.write(text, end - text);
+}
+
+// quoted only when it has to be
+void write_csv_field(std::ostream& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out << field;
+        return;
+    }
+    out << '"';
+    for (char c : field) {
+        if (c == '"') {
+            out << '"';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+void write_json_string(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out << escape;
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void write_csv(const group_result_t& result, std::ostream& out) {
+    bool first = true;
+    for (auto *names : {&result.key_columns, &result.value_columns}) {
+        for (auto &name : *names) {
+            out << (first ? "" : ",");
+            write_csv_field(out, name);
+            first = false;
+        }
+    }
+    out << '\n';
+
+    for (std::size_t g = 0; g < result.groups; ++g) {
+        first = true;
+        for (auto &column : result.keys) {
+            out << (first ? "" : ",");
+            write_csv_field(out, column[g]);
+            first = false;
+        }
+        for (auto &column : result.values) {
+            out << (first ? "" : ",");
+            if (!std::isnan(column[g])) {
+                write_number(out, column[g]);
+            }
+            first = false;
+        }
+        out << '\n';
+    }
+}
+
+// an array of objects, one per group
+void write_json(const group_result_t& result, std::ostream& out) {
+    out << "[";
+    for (std::size_t g = 0; g < result.groups; ++g) {
+        out << (g ? ",\n " : "\n ") << "{";
+        bool first = true;
+        for (std::size_t k = 0; k < result.keys.size(); ++k) {
+            out << (first ? "" : ", ");
+            write_json_string(out, result.key_columns[k]);
+            out << ": ";
+            write_json_string(out, result.keys[k][g]);
+            first = false;
+        }
+        for (std::size_t v = 0; v < result.values.size(); ++v) {
+            out << (first ? "" : ", ");
+            write_json_string(out, result.value_columns[v]);
+            out << ": ";
+            // json has no NaN or infinity
+            if (std::isfinite(result.values[v][g])) {
+                write_number(out, result.values[v][g]);
+            } else {
+                out << "null";
+            }
+            first = false;
+        }
+        out << "}";
+    }
+    out << (result.groups ? "\n]\n" : "]\n");
+}
+
+} // namespace
+
+std::optional<output_format_t> parse_output_format(std::string_view name) {
+    if (name == "csv") {
+        return output_format_t::csv;
+    }
+    if (name == "json") {
+        return output_format_t::json;
+    }
+    if (name == "binary") {
+        return output_format_t::binary;
+    }
+    return std::nullopt;
+}
+
+void write_result(const group_result_t& result, output_format_t format, std::ostream& out) {
+    switch (format) {
+    case output_format_t::csv:
+        write_csv(result, out);
+        break;
+    case output_format_t::json:
+        write_json(result, out);
+        break;
+    case output_format_t::binary: {
+        std::string frame = encode_result_frame(result);
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        break;
+    }
+    }
+}
+
+bool write_shared_memory(std::string name, std::string_view data) {
+    if (!name.starts_with('/')) {
+        name.insert(0, 1, '/');
+    }
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    if (data.empty() || ::ftruncate(fd, static_cast<off_t>(data.size())) != 0) {
+        ::close(fd);
+        return data.empty();
+    }
+
+    void *memory = ::mmap(nullptr, data.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    std::memcpy(memory, data.data(), data.size());
+    ::munmap(memory, data.size());
+    return true;
+}
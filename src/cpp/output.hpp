@@ -0,0 +1,27 @@
+#pragma once
+
+#include "groupby.hpp"
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+enum class output_format_t {
+    csv,
+    json,
+    binary, // an ipc frame holding a batch, see ipc.hpp and columnar.hpp
+};
+
+// "csv", "json" or "binary"
+std::optional<output_format_t> parse_output_format(std::string_view name);
+
+// key columns then value columns, one row per group. numbers are written
+// with the fewest digits that read back to the same double, NaN as an empty
+// csv cell or a json null. binary throws load_error_t like write_batch()
+void write_result(const group_result_t& result, output_format_t format, std::ostream& out);
+
+// data as the posix shared memory object name (a leading / is added if it's
+// missing), replacing what was there. other processes map it read-only, e.g.
+// /dev/shm/<name> on linux or multiprocessing.shared_memory in python
+bool write_shared_memory(std::string name, std::string_view data);
@@ -0,0 +1,138 @@
+#include "tips.hpp"
+
+#include "ipc.hpp"
+#include "trace.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+
+// fd the script finds the pipe on, see --ipc-fd in src/py/main.py
+constexpr int child_ipc_fd = 3;
+
+// how often a read that's waiting on the child checks for a cancelled load
+constexpr int cancel_poll_ms = 50;
+
+// everything until the child closes the pipe, nothing if the load got
+// cancelled first
+std::optional<std::string> read_all(int fd, const load_progress_t *progress) {
+    std::string data;
+    char buffer[4096];
+    while (true) {
+        if (progress) {
+            pollfd ready = {fd, POLLIN, 0};
+            int polled = ::poll(&ready, 1, cancel_poll_ms);
+            if (progress->cancelled) {
+                return std::nullopt;
+            }
+            if (polled == 0 || (polled < 0 && errno == EINTR)) {
+                continue;
+            }
+        }
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        data.append(buffer, static_cast<std::size_t>(n));
+    }
+    return data;
+}
+
+} // namespace
+
+tips_t get_tips_python(std::size_t top_n, load_progress_t *progress) {
+    TRACE_ZONE("get_tips_python");
+    int fds[2];
+    // close-on-exec, the dup2 below is what hands the write end to this child
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        throw load_error_t("ipc: couldn't create a pipe");
+    }
+
+    // the write end goes to the child as fd 3. the viewer opens everything
+    // else close-on-exec, so the child gets its stdio and this pipe only. its
+    // stdout goes to stderr so dmpv-batch's stdout stays just the result
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, STDERR_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], child_ipc_fd);
+    if (fds[1] != child_ipc_fd) {
+        posix_spawn_file_actions_addclose(&actions, fds[1]);
+    } else {
+        // a dup2 onto itself keeps close-on-exec set
+        ::fcntl(fds[1], F_SETFD, 0);
+    }
+
+    std::string fd_arg = std::to_string(child_ipc_fd);
+    std::string top_arg = std::to_string(top_n);
+    char *args[] = {
+        const_cast<char *>("python3"), const_cast<char *>("src/py/main.py"), // [FIXME] DEBUG PATH
+        const_cast<char *>("--ipc-fd"), fd_arg.data(), top_arg.data(), nullptr,
+    };
+
+    std::cout << "python3: starting src/py/main.py\n";
+    pid_t pid;
+    int ret;
+    {
+        TRACE_ZONE("python: spawn");
+        ret = posix_spawnp(&pid, "python3", &actions, nullptr, args, environ);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(fds[1]);
+    if (ret != 0) {
+        ::close(fds[0]);
+        std::cout << "python3: bad\n";
+        throw load_error_t("python3 could not be found, have you installed python?");
+    }
+
+    // interpreter start, the pandas import, the download and the query all
+    // happen before the frame shows up, the script prints that breakdown to stderr
+    std::optional<std::string> frame;
+    {
+        TRACE_ZONE("python: run and read frame");
+        frame = read_all(fds[0], progress);
+    }
+    ::close(fds[0]);
+
+    // the window closed mid-load, the script isn't waited out
+    if (!frame) {
+        ::kill(pid, SIGTERM);
+    }
+
+    int status = 0;
+    {
+        TRACE_ZONE("python: wait");
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+    if (!frame) {
+        throw load_error_t("python3: cancelled");
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw load_error_t("python3: src/py/main.py failed");
+    }
+
+    tips_t values;
+    std::string error;
+    TRACE_ZONE("python: decode");
+    if (!decode_tips_frame(*frame, values, error)) {
+        throw load_error_t("ipc: bad frame from python (" + error + ")");
+    }
+
+    std::cout << "ipc: ok\n";
+
+    return values;
+}
@@ -0,0 +1,160 @@
+#include "tips.hpp"
+
+#include <iostream>
+
+#if DMPV_EMBED_PYTHON
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "trace.hpp"
+
+namespace {
+
+// the interpreter and the imported script live for the rest of the process,
+// that's the point: pandas gets imported (and the csv fetched) only once.
+// there's no Py_Finalize, pandas doesn't like being torn down and the os
+// reclaims it all at exit anyway
+PyObject *script = nullptr;
+std::optional<std::string> start_error; // start_python() failed, every load reports it
+std::once_flag started;
+
+// python's own error (if there is one) goes to stderr, the gil has to be held
+std::string python_error(const char *what) {
+    if (PyErr_Occurred()) {
+        PyErr_Print();
+    }
+    return std::string("python: ") + what;
+}
+
+// holds the gil for as long as it's in scope, errors throw with it held
+class gil_t {
+public:
+    gil_t() : state(PyGILState_Ensure()) {}
+    ~gil_t() { PyGILState_Release(state); }
+
+    gil_t(const gil_t&) = delete;
+    gil_t& operator=(const gil_t&) = delete;
+
+private:
+    PyGILState_STATE state;
+};
+
+// a new reference, dropped however the scope is left
+struct decref_t {
+    void operator()(PyObject *object) const { Py_DECREF(object); }
+};
+using py_ref_t = std::unique_ptr<PyObject, decref_t>;
+
+// a buffer view, released however the scope is left
+struct buffer_t {
+    Py_buffer view = {};
+    bool held = false;
+
+    ~buffer_t() {
+        if (held) {
+            PyBuffer_Release(&view);
+        }
+    }
+};
+
+void start_python() {
+    TRACE_ZONE("python: start interpreter");
+    std::cout << "python: embedding the interpreter\n";
+    Py_InitializeEx(0); // no signal handlers, the viewer owns those
+
+    // main.py prints its progress, stdout is dmpv-batch's result
+    PyObject *stderr_stream = PySys_GetObject("stderr"); // borrowed
+    if (!stderr_stream || PySys_SetObject("stdout", stderr_stream) != 0) {
+        start_error = python_error("couldn't send sys.stdout to stderr");
+    }
+
+    PyObject *path = PySys_GetObject("path"); // borrowed
+    py_ref_t dir(PyUnicode_FromString("src/py")); // [FIXME] DEBUG PATH, same as python_backend.cpp
+    if (!start_error && (!path || !dir || PyList_Insert(path, 0, dir.get()) != 0)) {
+        start_error = python_error("couldn't extend sys.path");
+    }
+    dir.reset();
+
+    if (!start_error) {
+        script = PyImport_ImportModule("main");
+        if (!script) {
+            start_error = python_error("couldn't import src/py/main.py");
+        }
+    }
+
+    // hand the gil back, whichever thread loads next takes it again
+    PyEval_SaveThread();
+}
+
+// true for a 1d buffer of native doubles, which is what numpy's float64 exports
+bool is_double_vector(const Py_buffer& view) {
+    std::string_view format = view.format ? view.format : "B";
+    return view.ndim == 1 && view.itemsize == sizeof(double) && (format == "d" || format == "<d" || format == "=d");
+}
+
+} // namespace
+
+tips_t get_tips_python_embedded(std::size_t top_n) {
+    TRACE_ZONE("get_tips_python_embedded");
+    std::call_once(started, start_python);
+    if (start_error) {
+        throw load_error_t(*start_error);
+    }
+
+    // declared in this order so the buffer, then the result, then the gil
+    // are let go of on the way out, thrown or not
+    gil_t gil;
+
+    // (day names, float64 tips), see top_tips_columns() in main.py
+    py_ref_t result(PyObject_CallMethod(script, "top_tips_columns", "n", static_cast<Py_ssize_t>(top_n)));
+    if (!result || !PyTuple_Check(result.get()) || PyTuple_Size(result.get()) != 2) {
+        throw load_error_t(python_error("top_tips_columns() didn't return (days, tips)"));
+    }
+    PyObject *days = PyTuple_GetItem(result.get(), 0);
+    PyObject *tips = PyTuple_GetItem(result.get(), 1);
+    if (!PyList_Check(days)) {
+        throw load_error_t(python_error("top_tips_columns() days aren't a list"));
+    }
+
+    // the tips are read straight out of the array, no copy and no text
+    buffer_t buffer;
+    if (PyObject_GetBuffer(tips, &buffer.view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        throw load_error_t(python_error("top_tips_columns() tips don't support the buffer protocol"));
+    }
+    buffer.held = true;
+    Py_ssize_t count = PyList_Size(days);
+    if (!is_double_vector(buffer.view) || buffer.view.len / buffer.view.itemsize != count) {
+        throw load_error_t(python_error("top_tips_columns() tips aren't one float64 per day"));
+    }
+
+    tips_t values;
+    const auto *data = static_cast<const double *>(buffer.view.buf);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        Py_ssize_t size = 0;
+        const char *name = PyUnicode_AsUTF8AndSize(PyList_GetItem(days, i), &size);
+        if (!name) {
+            throw load_error_t(python_error("top_tips_columns() day names aren't strings"));
+        }
+        if (auto day = parse_day(std::string_view(name, static_cast<std::size_t>(size)))) {
+            values.set(*day, data[i]);
+        }
+    }
+
+    std::cout << "python: ok (embedded)\n";
+    return values;
+}
+
+#else
+
+tips_t get_tips_python_embedded(std::size_t) {
+    throw load_error_t("python: built without DMPV_EMBED_PYTHON, reconfigure with -DDMPV_EMBED_PYTHON=ON");
+}
+
+#endif
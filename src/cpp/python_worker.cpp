@@ -0,0 +1,250 @@
+#include "python_worker.hpp"
+
+#include "ipc.hpp"
+#include "trace.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+
+// fd the worker finds its end of the socket on, see --serve-fd in src/py/main.py
+constexpr int child_socket_fd = 3;
+
+// results are one row per group, tens of millions of them fit. anything bigger
+// is a broken stream
+constexpr std::uint32_t max_payload_size = 1u << 30;
+
+bool send_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        // MSG_NOSIGNAL, a dead worker shouldn't take the viewer down with SIGPIPE
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+// false when the stream ended, broke or (with SO_RCVTIMEO set) went quiet,
+// timed_out says which
+bool recv_all(int fd, char *data, std::size_t size, bool& timed_out) {
+    while (size > 0) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            timed_out = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+class worker_t {
+public:
+    ~worker_t() { stop(); }
+
+    // the frame the worker answered request with, nothing if it's gone or
+    // went timeout seconds without sending a byte (timed_out() tells which)
+    std::optional<std::string> exchange(const std::string& command, unsigned timeout, std::string_view request) {
+        if (pid < 0 || command != running_command) {
+            stop();
+            start(command);
+        }
+        set_timeout(timeout);
+        quiet = false;
+        if (!send_all(fd, request)) {
+            return std::nullopt;
+        }
+
+        std::string frame(ipc_header_size, '\0');
+        if (!recv_all(fd, frame.data(), frame.size(), quiet)) {
+            return std::nullopt;
+        }
+        std::uint32_t size = ipc_payload_size(frame);
+        if (size > max_payload_size) {
+            return std::nullopt;
+        }
+        frame.resize(ipc_header_size + size);
+        if (!recv_all(fd, frame.data() + ipc_header_size, size, quiet)) {
+            return std::nullopt;
+        }
+        return frame;
+    }
+
+    bool timed_out() const { return quiet; }
+
+    void stop() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        if (pid > 0) {
+            ::kill(pid, SIGTERM);
+            int status;
+            while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+            }
+            pid = -1;
+        }
+    }
+
+private:
+    void set_timeout(unsigned timeout) {
+        if (timeout == applied_timeout) {
+            return;
+        }
+        timeval wait = {static_cast<time_t>(timeout), 0}; // 0 is no timeout
+        if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait)) == 0) {
+            applied_timeout = timeout;
+        }
+    }
+
+    void start(const std::string& command) {
+        TRACE_ZONE("python worker: spawn");
+        int fds[2];
+        // close-on-exec, later spawns (a restart, the one-shot backend) mustn't
+        // inherit either end
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            throw load_error_t("python worker: couldn't create a socket");
+        }
+
+        // the worker gets fds[1] as fd 3 and nothing else, its stdout goes to
+        // stderr so dmpv-batch's stdout stays just the result
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, STDERR_FILENO, STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], child_socket_fd);
+        if (fds[1] != child_socket_fd) {
+            posix_spawn_file_actions_addclose(&actions, fds[1]);
+        } else {
+            // a dup2 onto itself keeps close-on-exec set
+            ::fcntl(fds[1], F_SETFD, 0);
+        }
+
+        // exec so the pid is the worker's own and SIGTERM reaches it
+        std::string script = "exec " + command + " --serve-fd " + std::to_string(child_socket_fd);
+        char *args[] = {
+            const_cast<char *>("sh"), const_cast<char *>("-c"), script.data(), nullptr,
+        };
+
+        std::cout << "python worker: starting " << command << "\n";
+        int ret = posix_spawn(&pid, "/bin/sh", &actions, nullptr, args, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(fds[1]);
+        if (ret != 0) {
+            ::close(fds[0]);
+            pid = -1;
+            throw load_error_t("python worker: couldn't run /bin/sh");
+        }
+
+        fd = fds[0];
+        running_command = command;
+        applied_timeout = 0;
+    }
+
+    int fd = -1;
+    pid_t pid = -1;
+    std::string running_command;
+    unsigned applied_timeout = 0; // SO_RCVTIMEO on fd, in seconds
+    bool quiet = false; // the last exchange() gave up on a worker that stopped answering
+};
+
+// loads can come from any thread, one query at a time goes over the socket
+std::mutex worker_mutex;
+worker_t worker;
+
+std::string join(const std::vector<std::string>& items, char separator) {
+    std::string joined;
+    for (auto &item : items) {
+        if (!joined.empty()) {
+            joined += separator;
+        }
+        joined += item;
+    }
+    return joined;
+}
+
+} // namespace
+
+group_result_t query_python_worker(const load_options_t& options) {
+    TRACE_ZONE("query_python_worker");
+    // a tab or newline inside a field would shift the fields after it or start
+    // another request, the line can't carry them
+    for (const std::string *field : {&options.input, &options.aggregate, &options.value, &options.order_by}) {
+        if (field->find_first_of("\t\n") != std::string::npos) {
+            throw load_error_t("python worker: '" + *field + "' has a tab or a newline, which can't be sent");
+        }
+    }
+    for (auto &column : options.group_by) {
+        if (column.find_first_of("\t\n,") != std::string::npos) {
+            throw load_error_t("python worker: '" + column + "' has a tab, newline or comma, which can't be sent");
+        }
+    }
+
+    std::string request = "query\t" + std::to_string(options.top_n) + "\t" + join(options.group_by, ',') + "\t"
+            + options.aggregate + "\t" + options.value + "\t" + options.order_by + "\t" + options.input + "\n";
+
+    std::lock_guard lock(worker_mutex);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        std::optional<std::string> frame;
+        {
+            TRACE_ZONE("python worker: query");
+            frame = worker.exchange(options.worker_command, options.worker_timeout, request);
+        }
+        if (!frame) {
+            if (worker.timed_out()) {
+                std::cerr << "python worker: no answer in " << options.worker_timeout << "s";
+            } else {
+                std::cerr << "python worker: the worker went away";
+            }
+            std::cerr << (attempt == 0 ? ", restarting it\n" : "\n");
+            worker.stop();
+            continue;
+        }
+
+        group_result_t result;
+        std::string error;
+        if (!decode_result_frame(*frame, result, error)) {
+            throw load_error_t("python worker: " + error);
+        }
+        std::cout << "python worker: ok\n";
+        return result;
+    }
+
+    throw load_error_t("python worker: " + options.worker_command + " keeps failing, giving up");
+}
+
+tips_t get_tips_python_worker(const load_options_t& options) {
+    group_result_t result = query_python_worker(options);
+
+    tips_t values;
+    if (result.keys.empty() || result.values.empty()) {
+        return values;
+    }
+    for (std::size_t g = 0; g < result.groups; ++g) {
+        if (auto day = parse_day(result.keys[0][g])) {
+            values.set(*day, result.values[0][g]);
+        }
+    }
+    return values;
+}
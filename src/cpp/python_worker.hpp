@@ -0,0 +1,22 @@
+#pragma once
+
+#include "groupby.hpp"
+#include "tips.hpp"
+
+// the python worker: src/py/main.py started once with --serve-fd and kept
+// running, so the interpreter, the pandas import and every dataset it has
+// read stay loaded between queries. it's spawned on the first query through
+// `sh -c "exec <worker_command> --serve-fd 3"` with one end of a unix socket
+// pair as fd 3, anything speaking the protocol can stand in for it.
+//
+// per query the viewer writes one line, fields separated by tabs:
+//
+//   query | top n | group by (comma separated) | aggregate | value | order by | input
+//
+// fields with a tab or a newline (or a key column with a comma) can't be
+// sent and throw load_error_t before anything goes out
+// and the worker answers with a result frame, or an error frame if the query
+// failed (both in ipc.hpp). a worker that dies, hangs up or goes
+// worker_timeout seconds without sending anything is restarted and the query
+// sent again, once
+group_result_t query_python_worker(const load_options_t& options);
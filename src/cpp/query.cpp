@@ -0,0 +1,52 @@
+#include "query.hpp"
+
+#include "python_worker.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+bool is_tips_query(const load_options_t& options) {
+    return options.group_by.size() == 1 && options.group_by[0] == "day" && options.aggregate == "sum"
+            && options.value == "tip" && options.order_by == "tip";
+}
+
+group_result_t to_result(const tips_t& tips) {
+    group_result_t result;
+    result.key_columns = {"day"};
+    result.value_columns = {"sum(tip)"};
+    result.keys.resize(1);
+    result.values.resize(1);
+    for (day_t day : all_days) {
+        if (tips.has(day)) {
+            result.keys[0].emplace_back(day_name(day));
+            result.values[0].push_back(tips[day]);
+        }
+    }
+    result.groups = tips.size();
+    return result;
+}
+
+group_result_t load_result(const load_options_t& options, load_progress_t *progress) {
+    if (is_tips_query(options)) {
+        return to_result(get_tips(options, progress));
+    }
+
+    // pandas runs any other query itself
+    if (options.backend == backend_t::python_worker) {
+        return query_python_worker(options);
+    }
+
+    if (options.backend != backend_t::native) {
+        throw load_error_t("python3: only the default query (sum of tip by day) is supported");
+    }
+
+    table_t table = load_table(options.input, progress);
+
+    std::vector<std::size_t> rows;
+    if (options.top_n > 0) {
+        rows = top_rows(table, options.order_by, options.top_n);
+    }
+
+    aggregate_spec_t aggregate = {options.aggregate, options.value};
+    return group_by(table, options.group_by, {&aggregate, 1}, options.top_n > 0 ? &rows : nullptr);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "groupby.hpp"
+#include "tips.hpp"
+
+// true for the default query (sum of tip per day over the top rows by tip)
+bool is_tips_query(const load_options_t& options);
+
+// tips_t as a result table, the shape everything after loading works with
+group_result_t to_result(const tips_t& tips);
+
+// the default query (sum of tip per day over the top rows by tip) goes
+// through get_tips() and its streaming backends, everything else loads the
+// csv into a table and runs it through group_by()
+group_result_t load_result(const load_options_t& options, load_progress_t *progress = nullptr);
@@ -0,0 +1,83 @@
+// dmpv-render: runs the query over each input and writes its chart to a png,
+// nothing is shown on screen. inputs and outputs come in pairs so one process
+// (one window, one font atlas) can turn out a whole batch
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cli.hpp"
+#include "offscreen.hpp"
+#include "query.hpp"
+
+int main(int argc, char **argv) {
+    load_options_t options;
+    int width = 1280;
+    int height = 720;
+    std::string font;
+    bool software = false;
+    std::vector<std::pair<std::string, std::string>> charts;
+    std::vector<std::string> paths;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (parse_load_option(argc, argv, i, options)) {
+            continue;
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            usage |= std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0;
+        } else if (std::strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            font = argv[++i];
+        } else if (std::strcmp(argv[i], "--software") == 0) {
+            software = true;
+        } else if (argv[i][0] != '-') {
+            paths.emplace_back(argv[i]);
+        } else {
+            usage = true;
+        }
+    }
+    for (std::size_t i = 0; i + 1 < paths.size(); i += 2) {
+        charts.emplace_back(paths[i], paths[i + 1]);
+    }
+
+    if (usage || charts.empty() || paths.size() % 2 != 0) {
+        std::cerr << "usage: " << argv[0] << " " << load_usage << "\n"
+                << "       [--size 1280x720] [--font file.ttf] [--software] input.csv chart.png [input.csv chart.png ...]\n";
+        return 1;
+    }
+
+    std::optional<offscreen_renderer_t> renderer;
+    try {
+        renderer.emplace(width, height, font, software);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    for (auto &[input, output] : charts) {
+        options.input = input;
+        chart_model_t chart;
+        try {
+            chart = build_chart_model(load_result(options), default_colors, renderer->font());
+        } catch (const load_error_t& e) {
+            // the rest of the batch still gets rendered
+            std::cerr << e.what() << "\n";
+            ++failed;
+            continue;
+        }
+        if (!renderer->render(chart, output)) {
+            std::cerr << "render: " << output << " couldn't be written\n";
+            ++failed;
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "render: " << charts.size() - failed << " charts in " << elapsed.count() << "ms ("
+            << (renderer->is_software() ? "software" : "gpu") << ")\n";
+    return failed ? 1 : 0;
+}
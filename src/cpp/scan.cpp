@@ -0,0 +1,182 @@
+#include "scan.hpp"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DMPV_SCAN_X86 1
+#endif
+
+namespace {
+
+using mask_fn = std::uint64_t (*)(const char *, std::size_t);
+
+std::uint64_t delimiter_mask_scalar(const char *p, std::size_t n) {
+    if (n > scan_block) {
+        n = scan_block;
+    }
+
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        char c = p[i];
+        if (c == ',' || c == '"' || c == '\n') {
+            mask |= std::uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+#ifdef DMPV_SCAN_X86
+
+std::uint64_t delimiter_mask_sse2(const char *p, std::size_t n) {
+    if (n < scan_block) {
+        return delimiter_mask_scalar(p, n);
+    }
+
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < scan_block; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, quote)),
+                _mm_cmpeq_epi8(v, newline));
+        mask |= std::uint64_t(static_cast<std::uint16_t>(_mm_movemask_epi8(hit))) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+std::uint64_t delimiter_mask_avx2(const char *p, std::size_t n) {
+    if (n < scan_block) {
+        return delimiter_mask_scalar(p, n);
+    }
+
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    std::uint64_t mask = 0;
+    for (std::size_t i = 0; i < scan_block; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, quote)),
+                _mm256_cmpeq_epi8(v, newline));
+        mask |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(hit))) << i;
+    }
+    return mask;
+}
+
+#endif
+
+struct kernel_t {
+    mask_fn fn;
+    const char *name;
+};
+
+kernel_t pick_kernel() {
+#ifdef DMPV_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {delimiter_mask_avx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {delimiter_mask_sse2, "sse2"};
+    }
+#endif
+    return {delimiter_mask_scalar, "scalar"};
+}
+
+const kernel_t kernel = pick_kernel();
+
+// exact powers of ten, a mantissa below 2^53 divided by one of these rounds
+// the same way strtod would
+constexpr double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+bool is_eight_digits(const char *p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return (((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+            == 0x3333333333333333);
+}
+
+// eight ascii digits to an integer with a handful of multiplies (swar)
+std::uint32_t parse_eight_digits(const char *p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    v -= 0x3030303030303030;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32)))
+            + (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+    return static_cast<std::uint32_t>(v);
+}
+
+const char *parse_digits(const char *p, const char *end, std::uint64_t& mantissa) {
+    if constexpr (std::endian::native == std::endian::little) {
+        while (end - p >= 8 && is_eight_digits(p)) {
+            mantissa = mantissa * 100000000 + parse_eight_digits(p);
+            p += 8;
+        }
+    }
+    while (p != end && static_cast<unsigned char>(*p - '0') < 10) {
+        mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    return p;
+}
+
+bool parse_decimal_slow(std::string_view text, double& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+} // namespace
+
+std::uint64_t delimiter_mask(const char *p, std::size_t n) {
+    return kernel.fn(p, n);
+}
+
+const char *delimiter_kernel() {
+    return kernel.name;
+}
+
+bool parse_decimal(std::string_view text, double& value) {
+    const char *p = text.data();
+    const char *end = p + text.size();
+
+    bool negative = p != end && *p == '-';
+    if (negative) {
+        ++p;
+    }
+
+    std::uint64_t mantissa = 0;
+    const char *int_start = p;
+    p = parse_digits(p, end, mantissa);
+    std::size_t digits = static_cast<std::size_t>(p - int_start);
+
+    std::size_t fraction = 0;
+    if (p != end && *p == '.') {
+        ++p;
+        const char *frac_start = p;
+        p = parse_digits(p, end, mantissa);
+        fraction = static_cast<std::size_t>(p - frac_start);
+    }
+    digits += fraction;
+
+    // 19 digits can't overflow, and 2^53 keeps the mantissa exact in a double
+    if (p != end || digits == 0 || digits > 19 || mantissa > (std::uint64_t(1) << 53)
+            || fraction >= std::size(pow10)) {
+        return parse_decimal_slow(text, value);
+    }
+
+    value = static_cast<double>(mantissa) / pow10[fraction];
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
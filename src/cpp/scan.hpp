@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// bytes covered by one delimiter_mask() call
+constexpr std::size_t scan_block = 64;
+
+// bit i is set when p[i] is ',', '"' or '\n', only the first min(n, 64) bytes
+// are looked at. dispatches to the widest kernel the cpu supports
+std::uint64_t delimiter_mask(const char *p, std::size_t n);
+
+// "avx2", "sse2" or "scalar"
+const char *delimiter_kernel();
+
+// plain decimals ("16.99", "-3", "0.5") take a fast exact path, anything
+// else (exponents, very long mantissas) falls back to std::from_chars
+bool parse_decimal(std::string_view text, double& value);
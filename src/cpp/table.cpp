@@ -0,0 +1,253 @@
+#include "table.hpp"
+
+#include "csv.hpp"
+#include "scan.hpp"
+#include "top_k.hpp"
+#include "trace.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <unordered_map>
+
+namespace {
+
+// rows looked at to decide a column's type
+constexpr std::size_t sniff_rows = 1000;
+
+// how often progress is published
+constexpr std::size_t progress_interval = 1024 * 1024;
+
+// how much more room the columns get than the sampled rows suggest
+constexpr double expected_rows_slack = 1.1;
+
+// arena space on top of the columns, for the dictionaries
+constexpr std::size_t arena_extra = 64 * 1024;
+
+bool parse_integer(std::string_view text, std::int64_t& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// what the first rows say about the columns
+struct sniffed_t {
+    std::vector<column_type_t> types;
+    double row_bytes = 0; // csv bytes per row on average, 0 without rows
+};
+
+sniffed_t sniff(std::string_view data, std::size_t columns) {
+    std::vector<bool> all_integer(columns, true);
+    std::vector<bool> all_number(columns, true);
+    std::vector<bool> any_value(columns, false);
+
+    csv_scanner scanner(data);
+    csv_scanner::record_t record;
+    scanner.next(record); // header
+    std::size_t begin = scanner.offset();
+
+    std::size_t rows = 0;
+    for (; rows < sniff_rows && scanner.next(record); ++rows) {
+        for (std::size_t i = 0; i < columns && i < record.count; ++i) {
+            std::string_view field = record.fields[i];
+            if (field.empty()) {
+                continue;
+            }
+            any_value[i] = true;
+
+            std::int64_t integer;
+            double number;
+            if (all_integer[i] && !parse_integer(field, integer)) {
+                all_integer[i] = false;
+            }
+            if (all_number[i] && !parse_decimal(field, number)) {
+                all_number[i] = false;
+            }
+        }
+    }
+
+    sniffed_t sniffed;
+    sniffed.row_bytes = rows > 0 ? static_cast<double>(scanner.offset() - begin) / rows : 0;
+    for (std::size_t i = 0; i < columns; ++i) {
+        if (rows == 0) {
+            // no data to go by, numbers can still be summed (to nothing) and
+            // grouped, like the tips path does with a header-only file
+            sniffed.types.push_back(column_type_t::number);
+        } else if (!any_value[i] || !all_number[i]) {
+            sniffed.types.push_back(column_type_t::text);
+        } else if (all_integer[i]) {
+            sniffed.types.push_back(column_type_t::integer);
+        } else {
+            sniffed.types.push_back(column_type_t::number);
+        }
+    }
+    return sniffed;
+}
+
+void promote_to_number(column_t& column) {
+    column.numbers.reserve(column.integers.capacity());
+    column.numbers.assign(column.integers.begin(), column.integers.end());
+    column.integers.clear();
+    column.type = column_type_t::number;
+}
+
+// dictionary -> code for one text column, only needed while loading
+using lookup_t = std::pmr::unordered_map<std::string_view, std::uint32_t>;
+
+void append_cell(column_t& column, lookup_t& lookup, std::string_view field) {
+    switch (column.type) {
+        case column_type_t::integer: {
+            std::int64_t value;
+            if (parse_integer(field, value)) {
+                column.integers.push_back(value);
+                return;
+            }
+            promote_to_number(column);
+            [[fallthrough]];
+        }
+        case column_type_t::number: {
+            double value;
+            if (!parse_decimal(field, value)) {
+                value = std::numeric_limits<double>::quiet_NaN();
+            }
+            column.numbers.push_back(value);
+            return;
+        }
+        case column_type_t::text: {
+            auto [it, inserted] = lookup.try_emplace(field, static_cast<std::uint32_t>(column.dictionary.size()));
+            if (inserted) {
+                column.dictionary.push_back(field);
+            }
+            column.codes.push_back(it->second);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+const column_t *table_t::find(std::string_view name) const {
+    for (auto &column : columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+table_t load_table(const std::string& path, load_progress_t *progress) {
+    TRACE_ZONE("load_table");
+    std::cout << "table: mapping " << path << "\n";
+
+    table_t table;
+    table.source = std::make_unique<mapped_file>(path);
+    if (!table.source->is_open()) {
+        throw load_error_t("file: " + path + " couldn't be found or opened");
+    }
+    if (progress) {
+        progress->bytes_total = table.source->size();
+    }
+
+    csv_scanner scanner(table.source->view());
+    csv_scanner::record_t record;
+    if (!scanner.next(record)) {
+        throw load_error_t("csv: " + path + " is empty");
+    }
+    sniffed_t sniffed = sniff(table.source->view(), record.count);
+
+    // a guess at the row count from the sampled row length, with some slack
+    // since a guess that's short makes the columns grow (and the arena keep
+    // the smaller copies) while one that's long only costs untouched pages
+    std::size_t expected_rows = sniffed.row_bytes > 0
+            ? static_cast<std::size_t>(table.source->size() / sniffed.row_bytes * expected_rows_slack) + 1
+            : 0;
+    std::size_t arena_size = arena_extra;
+    for (column_type_t type : sniffed.types) {
+        arena_size += expected_rows * (type == column_type_t::text ? 1 : 8);
+    }
+    table.arena = std::make_unique<std::pmr::monotonic_buffer_resource>(arena_size);
+
+    // the lookups only live as long as the load, so they get an arena of their own
+    std::pmr::monotonic_buffer_resource scratch;
+    std::vector<lookup_t> lookups;
+    table.columns.reserve(record.count);
+    lookups.reserve(record.count);
+    for (std::size_t i = 0; i < record.count; ++i) {
+        column_t& column = table.columns.emplace_back(std::string(record.fields[i]), sniffed.types[i], table.arena.get());
+        switch (column.type) {
+            case column_type_t::integer: column.integers.reserve(expected_rows); break;
+            case column_type_t::number: column.numbers.reserve(expected_rows); break;
+            case column_type_t::text: column.codes.reserve(expected_rows); break;
+        }
+        lookups.emplace_back(&scratch);
+    }
+
+    std::size_t reported = 0;
+    std::size_t reported_rows = 0;
+    while (scanner.next(record)) {
+        for (std::size_t i = 0; i < table.columns.size(); ++i) {
+            append_cell(table.columns[i], lookups[i], i < record.count ? record.fields[i] : std::string_view());
+        }
+        ++table.rows;
+
+        if (progress && scanner.offset() - reported >= progress_interval) {
+            progress->bytes_parsed += scanner.offset() - reported;
+            progress->rows += table.rows - reported_rows;
+            reported = scanner.offset();
+            reported_rows = table.rows;
+            if (progress->cancelled) {
+                break;
+            }
+        }
+    }
+    if (progress) {
+        progress->bytes_parsed += scanner.offset() - reported;
+        progress->rows += table.rows - reported_rows;
+    }
+
+    std::size_t row_bytes = 0;
+    for (auto &column : table.columns) {
+        row_bytes += column.type == column_type_t::text ? column.codes.bytes_per_code() : 8;
+    }
+
+    std::cout << "table: " << table.rows << " rows, " << table.columns.size() << " columns ok ("
+            << row_bytes << " bytes/row)\n";
+    return table;
+}
+
+const column_t& require_column(const table_t& table, std::string_view name, bool numeric) {
+    const column_t *column = table.find(name);
+    if (!column) {
+        throw load_error_t("table: no column named '" + std::string(name) + "'");
+    }
+    if (numeric && column->type == column_type_t::text) {
+        throw load_error_t("table: column '" + std::string(name) + "' isn't numeric");
+    }
+    return *column;
+}
+
+std::vector<std::size_t> top_rows(const table_t& table, std::string_view name, std::size_t k) {
+    TRACE_ZONE("top_rows");
+    const column_t& column = require_column(table, name, true);
+
+    struct row_t {
+        double value;
+        std::size_t index;
+    };
+    top_k<row_t, kept_before> top(k);
+    for (std::size_t i = 0; i < table.rows; ++i) {
+        double value = numeric_at(column, i);
+        if (!std::isnan(value)) {
+            top.push({value, i});
+        }
+    }
+
+    std::vector<std::size_t> rows;
+    rows.reserve(top.size());
+    for (auto &row : top.sorted()) {
+        rows.push_back(row.index);
+    }
+    return rows;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "tips.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class column_type_t {
+    integer,
+    number,
+    text,
+};
+
+// dictionary codes kept as narrow as the dictionary allows: one byte each
+// until there are more than 256 distinct values, then two, then four
+class code_vector_t {
+public:
+    explicit code_vector_t(std::pmr::memory_resource *arena) : narrow(arena), medium(arena), wide(arena) {}
+
+    // room for rows codes at the current width
+    void reserve(std::size_t rows) {
+        switch (width) {
+            case 1: narrow.reserve(rows); break;
+            case 2: medium.reserve(rows); break;
+            default: wide.reserve(rows); break;
+        }
+    }
+
+    void push_back(std::uint32_t code) {
+        if (width == 1 && code > 0xFF) {
+            widen(code > 0xFFFF ? 4 : 2);
+        } else if (width == 2 && code > 0xFFFF) {
+            widen(4);
+        }
+
+        switch (width) {
+            case 1: narrow.push_back(static_cast<std::uint8_t>(code)); break;
+            case 2: medium.push_back(static_cast<std::uint16_t>(code)); break;
+            default: wide.push_back(code); break;
+        }
+    }
+
+    std::uint32_t operator[](std::size_t i) const {
+        switch (width) {
+            case 1: return narrow[i];
+            case 2: return medium[i];
+            default: return wide[i];
+        }
+    }
+
+    std::size_t size() const { return width == 1 ? narrow.size() : width == 2 ? medium.size() : wide.size(); }
+    std::size_t bytes_per_code() const { return width; }
+
+    // calls f with a span of the codes at their actual width, for tight loops
+    template <typename F>
+    void visit(F&& f) const {
+        switch (width) {
+            case 1: f(std::span<const std::uint8_t>(narrow)); break;
+            case 2: f(std::span<const std::uint16_t>(medium)); break;
+            default: f(std::span<const std::uint32_t>(wide)); break;
+        }
+    }
+
+private:
+    // the narrow codes stay in the arena until the table goes, widening happens
+    // at most twice per column
+    void widen(std::size_t next) {
+        std::size_t rows = size();
+        if (next == 2) {
+            medium.reserve(std::max(rows, narrow.capacity()));
+            medium.assign(narrow.begin(), narrow.end());
+        } else {
+            wide.reserve(std::max(rows, std::max(narrow.capacity(), medium.capacity())));
+            for (std::size_t i = 0; i < rows; ++i) {
+                wide.push_back((*this)[i]);
+            }
+            medium.clear();
+        }
+        narrow.clear();
+        width = next;
+    }
+
+    std::pmr::vector<std::uint8_t> narrow;
+    std::pmr::vector<std::uint16_t> medium;
+    std::pmr::vector<std::uint32_t> wide;
+    std::size_t width = 1;
+};
+
+// one csv column, only the members matching type are filled. text is
+// dictionary encoded while parsing, a cell is a code into dictionary.
+// everything lives in the table's arena
+struct column_t {
+    column_t(std::string name, column_type_t type, std::pmr::memory_resource *arena)
+            : name(std::move(name)), type(type), integers(arena), numbers(arena), codes(arena), dictionary(arena) {}
+
+    std::string name;
+    column_type_t type;
+    std::pmr::vector<std::int64_t> integers;
+    std::pmr::vector<double> numbers; // unparseable cells are NaN
+
+    code_vector_t codes;
+    std::pmr::vector<std::string_view> dictionary; // points into table_t::source
+
+    std::string_view text_at(std::size_t row) const { return dictionary[codes[row]]; }
+};
+
+// a loaded csv and everything parsed out of it. the columns are allocated
+// from one monotonic arena sized from the file up front, so loading makes a
+// handful of big allocations instead of one per growth step, and dropping
+// the table hands it all back at once without fragmenting the heap
+struct table_t {
+    std::unique_ptr<mapped_file> source;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena; // before columns, they're freed into it
+    std::vector<column_t> columns;
+    std::size_t rows = 0;
+
+    const column_t *find(std::string_view name) const;
+};
+
+// reads a whole csv into typed columns. types are sniffed from the first rows,
+// an integer column that later turns out to hold decimals becomes a number
+// column, a numeric cell that doesn't parse becomes NaN
+table_t load_table(const std::string& path, load_progress_t *progress);
+
+// a numeric cell as a double, column must not be text
+inline double numeric_at(const column_t& column, std::size_t row) {
+    if (column.type == column_type_t::integer) {
+        return static_cast<double>(column.integers[row]);
+    }
+    return column.numbers[row];
+}
+
+// the named column, throws load_error_t when it's missing or (with numeric) holds text
+const column_t& require_column(const table_t& table, std::string_view name, bool numeric);
+
+// indices of the k rows with the biggest values in column, ties go to the
+// earlier row, NaN never makes the cut
+std::vector<std::size_t> top_rows(const table_t& table, std::string_view column, std::size_t k);
@@ -0,0 +1,37 @@
+#include "tips.hpp"
+
+#include "cache.hpp"
+#include "trace.hpp"
+
+tips_t get_tips(const load_options_t& options, load_progress_t *progress) {
+    TRACE_ZONE("get_tips");
+
+    switch (options.backend) {
+        case backend_t::python:
+            return get_tips_python(options.top_n, progress);
+        case backend_t::python_embedded:
+            return get_tips_python_embedded(options.top_n);
+        case backend_t::python_worker:
+            return get_tips_python_worker(options);
+        case backend_t::native:
+        default:
+            break;
+    }
+
+    // the input as the parse starts on it, what a store is checked against
+    std::optional<cache_header_t> source;
+    if (options.use_cache) {
+        TRACE_ZONE("cache lookup");
+        source = describe_cache_source(options);
+        if (auto cached = source ? load_cached_tips(options, *source) : std::nullopt) {
+            return *cached;
+        }
+    }
+
+    tips_t tips = get_tips_native(options, progress);
+    if (source && !(progress && progress->cancelled)) {
+        TRACE_ZONE("cache store");
+        store_cached_tips(options, *source, tips);
+    }
+    return tips;
+}
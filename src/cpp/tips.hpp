@@ -0,0 +1,124 @@
+#pragma once
+
+#include "day.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// one slot per weekday plus a mask of which days actually showed up, no
+// allocations and a lookup is just an index. doubles like pandas, the chart
+// narrows to float when it draws
+struct tips_t {
+    std::array<double, day_count> values{};
+    std::uint8_t present = 0;
+
+    void set(day_t day, double value) {
+        values[static_cast<std::size_t>(day)] = value;
+        present |= bit(day);
+    }
+
+    bool has(day_t day) const { return present & bit(day); }
+    double operator[](day_t day) const { return values[static_cast<std::size_t>(day)]; }
+
+    std::size_t size() const { return static_cast<std::size_t>(std::popcount(present)); }
+    bool empty() const { return present == 0; }
+
+    double total() const {
+        double sum = 0;
+        for (double value : values) {
+            sum += value;
+        }
+        return sum;
+    }
+
+private:
+    static std::uint8_t bit(day_t day) { return static_cast<std::uint8_t>(1u << static_cast<unsigned>(day)); }
+};
+
+enum class backend_t {
+    native,
+    python,
+    python_embedded, // needs DMPV_EMBED_PYTHON, see python_embed.cpp
+    python_worker, // see python_worker.hpp
+};
+
+// the order top rows are kept in, for any row with a value (the tip, or
+// whatever --order-by picked) and an index: a bigger value wins and on equal
+// values the earlier row wins, same as a stable sort. the tips loaders and the
+// table engine's top_rows() both keep rows this way, so they agree
+struct kept_before {
+    template <typename Row>
+    bool operator()(const Row& a, const Row& b) const {
+        if (a.value != b.value) {
+            return a.value > b.value;
+        }
+        return a.index < b.index;
+    }
+};
+
+// a running sum that carries each add's rounding error into the next one, the
+// way pandas' groupby sum does (kahan). the same rows added in the same order
+// come out with pandas' digits
+struct kahan_sum_t {
+    double sum = 0;
+    double compensation = 0;
+
+    void add(double value) {
+        double y = value - compensation;
+        double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+
+    void merge(const kahan_sum_t& other) {
+        add(other.sum);
+        add(-other.compensation);
+    }
+};
+
+// what the pandas script always kept before --top existed
+constexpr std::size_t default_top_n = 100;
+
+struct load_options_t {
+    backend_t backend = backend_t::native;
+    std::string input = "tips.csv";
+    std::size_t top_n = default_top_n; // rows with the biggest order_by that get aggregated, 0 for all
+    unsigned threads = 0; // native only, 0 means one per core
+    bool use_cache = true; // native only, see cache.hpp
+    std::string worker_command = "python3 src/py/main.py"; // python_worker only, [FIXME] DEBUG PATH
+    unsigned worker_timeout = 120; // python_worker only, seconds without a byte of the answer before it's restarted
+
+    // the query, anything but the default goes through the table engine (query.hpp)
+    std::vector<std::string> group_by = {"day"};
+    std::string aggregate = "sum";
+    std::string value = "tip";
+    std::string order_by = "tip";
+};
+
+// filled in by the loader while it runs so another thread can draw a progress
+// bar, bytes_total stays 0 when the backend can't tell how much is left
+struct load_progress_t {
+    std::atomic<std::uint64_t> bytes_total = 0;
+    std::atomic<std::uint64_t> bytes_parsed = 0;
+    std::atomic<std::uint64_t> rows = 0;
+    std::atomic<bool> cancelled = false; // set by the reader, the loader gives up early
+};
+
+// what the loaders throw when there's no result to give (a missing file or
+// column, a python backend that failed). the viewer loads on a background
+// thread, this gets the message to the window instead of exiting under it
+struct load_error_t : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+tips_t get_tips(const load_options_t& options, load_progress_t *progress = nullptr);
+tips_t get_tips_native(const load_options_t& options, load_progress_t *progress);
+tips_t get_tips_python(std::size_t top_n, load_progress_t *progress);
+tips_t get_tips_python_embedded(std::size_t top_n);
+tips_t get_tips_python_worker(const load_options_t& options);
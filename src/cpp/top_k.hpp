@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// keeps the k best values seen so far in a bounded heap, O(log k) per kept
+// value and O(1) for the (common) case of a value that doesn't make the cut.
+// better(a, b) must be a strict weak order, true when a should be kept over b
+template <typename T, typename Better>
+class top_k {
+public:
+    explicit top_k(std::size_t k, Better better = {}) : k(k), better(better) {
+        heap.reserve(std::min<std::size_t>(k, 4096));
+    }
+
+    bool push(const T& value) {
+        if (heap.size() < k) {
+            heap.push_back(value);
+            std::push_heap(heap.begin(), heap.end(), better);
+            return true;
+        }
+        if (k == 0 || !better(value, heap.front())) {
+            return false;
+        }
+
+        std::pop_heap(heap.begin(), heap.end(), better);
+        heap.back() = value;
+        std::push_heap(heap.begin(), heap.end(), better);
+        return true;
+    }
+
+    void clear() { heap.clear(); }
+
+    void merge(const top_k& other) {
+        for (auto &value : other.heap) {
+            push(value);
+        }
+    }
+
+    // the value that would be dropped next
+    const T& worst() const { return heap.front(); }
+
+    std::size_t size() const { return heap.size(); }
+    std::size_t capacity() const { return k; }
+    bool full() const { return heap.size() == k; }
+
+    // kept values in no particular order
+    const std::vector<T>& values() const { return heap; }
+
+    // kept values, best first
+    std::vector<T> sorted() const {
+        std::vector<T> out = heap;
+        std::sort_heap(out.begin(), out.end(), better);
+        return out;
+    }
+
+private:
+    std::size_t k;
+    Better better;
+    std::vector<T> heap;
+};
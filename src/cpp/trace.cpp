@@ -0,0 +1,121 @@
+#include "trace.hpp"
+
+#if DMPV_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// zones kept per thread, about 1.5 MiB each
+constexpr std::size_t ring_size = 1 << 16;
+
+// how far back trace_last_ms() looks, it runs every frame
+constexpr std::uint64_t last_lookback = 256;
+
+struct event_t {
+    const char *name;
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+struct ring_t {
+    std::vector<event_t> events = std::vector<event_t>(ring_size);
+    std::atomic<std::uint64_t> written = 0; // ever, the slot is written % ring_size
+    unsigned thread;
+};
+
+// rings outlive their threads so a finished worker still shows up in the export
+struct registry_t {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ring_t>> rings;
+};
+
+registry_t& registry() {
+    static registry_t instance;
+    return instance;
+}
+
+ring_t& this_thread_ring() {
+    thread_local std::shared_ptr<ring_t> ring = [] {
+        auto ring = std::make_shared<ring_t>();
+        std::lock_guard lock(registry().mutex);
+        ring->thread = static_cast<unsigned>(registry().rings.size());
+        registry().rings.push_back(ring);
+        return ring;
+    }();
+    return *ring;
+}
+
+const auto process_start = std::chrono::steady_clock::now();
+
+void write_json_string(std::FILE *file, const char *text) {
+    std::fputc('"', file);
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*text, file);
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+std::uint64_t trace_now() {
+    return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - process_start).count());
+}
+
+void trace_record(const char *name, std::uint64_t begin, std::uint64_t end) {
+    ring_t& ring = this_thread_ring();
+    std::uint64_t at = ring.written.load(std::memory_order_relaxed);
+    ring.events[at % ring_size] = {name, begin, end};
+    ring.written.store(at + 1, std::memory_order_release);
+}
+
+bool trace_export(const std::string& path) {
+    std::FILE *file = std::fopen(path.c_str(), "we"); // e: close-on-exec (glibc)
+    if (!file) {
+        return false;
+    }
+
+    std::lock_guard lock(registry().mutex);
+    std::fputs("{\"traceEvents\": [", file);
+    bool first = true;
+    for (auto &ring : registry().rings) {
+        std::uint64_t written = ring->written.load(std::memory_order_acquire);
+        std::uint64_t begin = written > ring_size ? written - ring_size : 0;
+        for (std::uint64_t i = begin; i < written; ++i) {
+            const event_t& event = ring->events[i % ring_size];
+            std::fputs(first ? "\n  {\"name\": " : ",\n  {\"name\": ", file);
+            write_json_string(file, event.name);
+            // complete events, timestamps in microseconds
+            std::fprintf(file, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}", ring->thread,
+                    event.begin / 1e3, (event.end - event.begin) / 1e3);
+            first = false;
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
+
+double trace_last_ms(const char *name) {
+    ring_t& ring = this_thread_ring();
+    std::uint64_t written = ring.written.load(std::memory_order_relaxed);
+    std::uint64_t oldest = written > last_lookback ? written - last_lookback : 0;
+    for (std::uint64_t i = written; i > oldest; --i) {
+        const event_t& event = ring.events[(i - 1) % ring_size];
+        if (event.name == name || std::strcmp(event.name, name) == 0) {
+            return (event.end - event.begin) / 1e6;
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+// scoped timing zones for finding where the time goes. TRACE_ZONE("name")
+// times the rest of the enclosing scope, name has to be a string literal.
+//
+// zones only exist when built with DMPV_TRACE (cmake -DDMPV_TRACE=ON),
+// otherwise the macro is empty and the functions below do nothing. each thread
+// records into its own ring buffer (the newest zones win once it's full), so
+// recording is two clock reads and a store with no locking
+#if DMPV_TRACE
+
+#include <cstdint>
+
+constexpr bool trace_enabled = true;
+
+// nanoseconds since the process started
+std::uint64_t trace_now();
+void trace_record(const char *name, std::uint64_t begin, std::uint64_t end);
+
+class trace_zone_t {
+public:
+    explicit trace_zone_t(const char *name) : name(name), begin(trace_now()) {}
+    ~trace_zone_t() { trace_record(name, begin, trace_now()); }
+
+    trace_zone_t(const trace_zone_t&) = delete;
+    trace_zone_t& operator=(const trace_zone_t&) = delete;
+
+private:
+    const char *name;
+    std::uint64_t begin;
+};
+
+#define DMPV_TRACE_CONCAT_(a, b) a##b
+#define DMPV_TRACE_CONCAT(a, b) DMPV_TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) trace_zone_t DMPV_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+
+// every thread's zones as chrome trace json, for chrome://tracing or
+// ui.perfetto.dev. meant for when the traced threads are done or idle, a
+// zone recorded while this runs may come out torn
+bool trace_export(const std::string& path);
+
+// how long the newest zone called name on this thread took, 0 if there's none
+double trace_last_ms(const char *name);
+
+#else
+
+constexpr bool trace_enabled = false;
+
+#define TRACE_ZONE(name) static_cast<void>(0)
+
+inline bool trace_export(const std::string&) { return false; }
+inline double trace_last_ms(const char *) { return 0; }
+
+#endif
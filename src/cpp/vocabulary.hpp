@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// most names one vocabulary holds
+constexpr std::size_t max_vocabulary_size = 8;
+
+// a small set of category names fixed at compile time (the days, yes/no...)
+// that text is matched against by its first prefix bytes, so "Thu", "Thur"
+// and "Thursday" are all the same name. find() is a perfect hash: the prefix
+// is packed into an integer, one multiply and shift picks the only slot it
+// could be in and one compare confirms it, no loop over the names and no
+// allocation. the multiplier is searched for when the vocabulary is built,
+// a vocabulary that can't have one doesn't compile
+class vocabulary_t {
+public:
+    // names have to differ within their first prefix (1 to 4) bytes
+    consteval vocabulary_t(std::span<const std::string_view> list, std::size_t prefix)
+            : count(list.size()), prefix(prefix) {
+        if (list.empty() || list.size() > max_vocabulary_size || prefix == 0 || prefix > 4) {
+            throw "vocabulary: 1 to max_vocabulary_size names and a prefix of 1 to 4 bytes";
+        }
+        std::array<std::uint32_t, max_vocabulary_size> keys{};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (list[i].size() < prefix) {
+                throw "vocabulary: a name is shorter than the prefix";
+            }
+            names[i] = list[i];
+            keys[i] = pack(list[i], prefix);
+            for (std::size_t j = 0; j < i; ++j) {
+                if (keys[j] == keys[i]) {
+                    throw "vocabulary: two names share a prefix";
+                }
+            }
+        }
+
+        // odd multipliers until every key lands in a slot of its own
+        for (multiplier = 1; multiplier < max_multiplier; multiplier += 2) {
+            std::array<bool, slot_count> used{};
+            bool perfect = true;
+            for (std::size_t i = 0; i < count && perfect; ++i) {
+                std::uint32_t slot = hash(keys[i], multiplier);
+                perfect = !used[slot];
+                used[slot] = true;
+            }
+            if (perfect) {
+                break;
+            }
+        }
+        if (multiplier >= max_multiplier) {
+            throw "vocabulary: no perfect multiplier";
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            slots[hash(keys[i], multiplier)] = {keys[i], static_cast<std::uint8_t>(i)};
+        }
+    }
+
+    // index of the name text starts like, if any
+    constexpr std::optional<std::size_t> find(std::string_view text) const {
+        if (text.size() < prefix) {
+            return std::nullopt;
+        }
+        std::uint32_t key = pack(text, prefix);
+        const slot_t& slot = slots[hash(key, multiplier)];
+        if (slot.key != key || slot.index == empty) {
+            return std::nullopt;
+        }
+        return slot.index;
+    }
+
+    // built from string literals, so .data() is null terminated
+    constexpr std::string_view name(std::size_t index) const { return names[index]; }
+    constexpr std::size_t size() const { return count; }
+
+private:
+    // 32 slots for at most 8 names, sparse enough that a multiplier turns up fast
+    static constexpr unsigned slot_bits = 5;
+    static constexpr std::size_t slot_count = std::size_t(1) << slot_bits;
+    static constexpr std::uint8_t empty = 0xFF;
+    // where the search gives up, well inside what a compiler evaluates at compile time
+    static constexpr std::uint32_t max_multiplier = 1 << 16;
+
+    struct slot_t {
+        std::uint32_t key = 0;
+        std::uint8_t index = empty;
+    };
+
+    static constexpr std::uint32_t pack(std::string_view text, std::size_t prefix) {
+        std::uint32_t key = 0;
+        for (std::size_t i = 0; i < prefix; ++i) {
+            key |= std::uint32_t(static_cast<unsigned char>(text[i])) << (8 * i);
+        }
+        return key;
+    }
+
+    static constexpr std::uint32_t hash(std::uint32_t key, std::uint32_t multiplier) {
+        return (key * multiplier) >> (32 - slot_bits);
+    }
+
+    std::array<std::string_view, max_vocabulary_size> names{};
+    std::array<slot_t, slot_count> slots{};
+    std::size_t count;
+    std::size_t prefix;
+    std::uint32_t multiplier = 1;
+};
+
+// find() as the enum whose values follow the vocabulary's order
+template <typename Enum>
+constexpr std::optional<Enum> parse_as(const vocabulary_t& vocabulary, std::string_view text) {
+    if (auto index = vocabulary.find(text)) {
+        return static_cast<Enum>(*index);
+    }
+    return std::nullopt;
+}
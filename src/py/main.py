@@ -1,23 +1,239 @@
+import time
+started = time.perf_counter()
+
+import numpy as np
 import pandas as pd
+import argparse
 import os
+import re
+import socket
+import struct
+import sys
+import zlib
 
-import time
+imported = time.perf_counter()
+
+# keep in sync with src/cpp/ipc.hpp
+IPC_MAGIC = b"DMPV"
+IPC_VERSION = 2
+IPC_FLAG_ERROR = 2
 
-def top_10_costliest_tips():
+# keep in sync with src/cpp/columnar.hpp
+BATCH_MAGIC = b"DMPB"
+BATCH_VERSION = 1
+BATCH_HEADER_SIZE = 24
+BATCH_F64 = 1
+BATCH_UTF8 = 2
+
+TIPS_URL = "https://raw.githubusercontent.com/mwaskom/seaborn-data/master/tips.csv"
+
+# keep in sync with tips_categories in src/cpp/categories.hpp: key columns
+# that come back in this order and spelled like this (matched on the first
+# prefix letters), the way the native group_by() has them. anything else sorts
+# after them as written
+CATEGORIES = {
+    "day": (3, ["Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday"]),
+    "time": (3, ["Lunch", "Dinner"]),
+    "smoker": (2, ["Yes", "No"]),
+    "sex": (3, ["Female", "Male"]),
+}
+
+def load_tips(source=TIPS_URL):
     # artificail delay
     time.sleep(0.5)
-    url = "https://raw.githubusercontent.com/mwaskom/seaborn-data/master/tips.csv"
-    file_path = "tmp_DMPV_output.raw"
+    data = pd.read_csv(source)
+    if data.empty:
+        # a header and nothing else, numbers like the native table has them
+        data = data.astype("float64")
+    # stdout may be the result (see below), so this goes to stderr
+    print("data: ok", file=sys.stderr)
+    return data
+
+# everything read so far, for the backends that keep this module around
+# (src/cpp/python_embed.cpp and --serve-fd). local files are read again once
+# they change, urls only once
+_datasets = {}
+
+def dataset(source=TIPS_URL):
+    stamp = os.stat(source).st_mtime_ns if os.path.exists(source) else None
+    cached = _datasets.get(source)
+    if cached is None or cached[0] != stamp:
+        cached = _datasets[source] = (stamp, load_tips(source))
+    return cached[1]
+
+def top_10_costliest_tips(n=100, data=None):
+    slept = time.perf_counter()
+    if data is None:
+        data = load_tips()
+    queried = time.perf_counter()
     #Sort Data
-    data = pd.read_csv(url)
-    print("data: ok")
-    sorted_data = data[['day' , 'tip']].sort_values(by='tip', ascending=False).head(100)
+    # nlargest keeps n rows in a heap instead of sorting everything, keep='first' breaks ties like a stable sort.
+    # n == 0 is every row, like --top 0 on the native side
+    sorted_data = data[['day' , 'tip']]
+    if n > 0:
+        sorted_data = sorted_data.nlargest(n, 'tip', keep='first')
 
     sorted_data2 = sorted_data.groupby('day', as_index=False)['tip'].sum()
+    done = time.perf_counter()
+
+    # where the time went, stdout may be the result so this goes to stderr
+    print(f"python: import {imported - started:.3f}s, sleep and read_csv {queried - slept:.3f}s, "
+          f"query {done - queried:.3f}s", file=sys.stderr)
+    return sorted_data2
+
+def top_tips_columns(n=100):
+    """the result as (day names, float64 tips), the tips are read through the buffer protocol"""
+    result = top_10_costliest_tips(n, dataset())
+    return result["day"].astype(str).tolist(), result["tip"].to_numpy(dtype="float64")
+
+def categorical(values, prefix, names):
+    """values respelled by CATEGORIES and ordered like the native engine orders them"""
+    by_prefix = {name[:prefix]: name for name in names}
+    spelled = values.map(lambda value: by_prefix.get(value[:prefix], value) if isinstance(value, str) else value)
+    others = sorted(set(spelled.dropna()) - set(names))
+    return pd.Categorical(spelled, categories=names + others, ordered=True)
+
+def percentile(aggregate):
+    """the q of "p90" or "p99.5" as a fraction, None for anything else. same rules as make_kernel() in groupby.cpp"""
+    if aggregate[:1] != "p" or not re.fullmatch(r"-?(\d+\.?\d*|\.\d+)([eE][-+]?\d+)?", aggregate[1:]):
+        return None
+    q = float(aggregate[1:])
+    return q / 100 if 0 <= q <= 100 else None
+
+def run_query(data, n, group_by, aggregate, value, order_by):
+    """any query the viewer can ask for (see load_options_t), as key columns followed by one value column"""
+    rows = data.nlargest(n, order_by, keep="first") if n > 0 else data
+    categories = {column: categorical(rows[column], *CATEGORIES[column])
+                  for column in group_by if column in CATEGORIES and pd.api.types.is_string_dtype(rows[column])}
+    if categories:
+        rows = rows.assign(**categories)
+    name = f"{aggregate}({value})"
+    if (q := percentile(aggregate)) is not None:
+        reduce = lambda values: values.quantile(q)
+    elif aggregate in ("sum", "mean", "count", "min", "max"):
+        reduce = lambda values: values.agg(aggregate)
+    else:
+        raise ValueError(f"unknown aggregate '{aggregate}'")
+
+    # no keys is a single total, like the native group_by()
+    if not group_by:
+        return pd.DataFrame({name: [reduce(rows[value])]})
+    return reduce(rows.groupby(group_by, sort=True, observed=True)[value]).reset_index(name=name)
+
+def frame(flags, payload):
+    header = struct.pack("<4sHHII", IPC_MAGIC, IPC_VERSION, flags, len(payload), zlib.crc32(payload))
+    return header + payload
+
+def padding(size):
+    return b"\0" * (-size % 8)
+
+def format_key(key):
+    # integral floats print like the native group_by() does, 2 rather than 2.0
+    if isinstance(key, float) and key.is_integer():
+        return str(int(key))
+    return str(key)
+
+def encode_batch(result, key_columns):
+    """result as a batch, key columns as utf8 and every other column as f64"""
+    columns = []
+    for column in key_columns:
+        keys = [format_key(key).encode() for key in result[column]]
+        offsets = np.zeros(len(keys) + 1, dtype="<u4")
+        offsets[1:] = np.cumsum([len(key) for key in keys])
+        columns.append((BATCH_UTF8, column, [offsets.tobytes(), b"".join(keys)]))
+    for column in result.columns:
+        if column not in key_columns:
+            columns.append((BATCH_F64, column, [result[column].to_numpy(dtype="<f8").tobytes()]))
+
+    schema = b""
+    for kind, name, _ in columns:
+        name = name.encode()[:255]
+        schema += struct.pack("<BB", kind, len(name)) + name
+    schema += padding(BATCH_HEADER_SIZE + len(schema))
+
+    # buffers go in the order their columns do, each starting on a multiple of 8
+    buffers = [buffer for _, _, column_buffers in columns for buffer in column_buffers]
+    offset = BATCH_HEADER_SIZE + len(schema) + 16 * len(buffers)
+    table, body = [], []
+    for buffer in buffers:
+        table.append(struct.pack("<QQ", offset, len(buffer)))
+        body += [buffer, padding(len(buffer))]
+        offset += len(buffer) + len(body[-1])
+
+    header = struct.pack("<4sHHQQ", BATCH_MAGIC, BATCH_VERSION, len(columns), len(result), offset)
+    return b"".join([header, schema] + table + body)
+
+def read_batch(buffer, at=0):
+    """the batch at buffer[at:] as {name: column}, f64 columns are numpy views into buffer.
+    for dmpv-batch --format binary output (a frame, so at=16) from a file or shared memory"""
+    magic, version, count, rows, _ = struct.unpack_from("<4sHHQQ", buffer, at)
+    if magic != BATCH_MAGIC or version != BATCH_VERSION:
+        raise ValueError("not a batch")
+
+    schema = []
+    pos = at + BATCH_HEADER_SIZE
+    for _ in range(count):
+        kind, name_size = struct.unpack_from("<BB", buffer, pos)
+        schema.append((kind, bytes(buffer[pos + 2:pos + 2 + name_size]).decode()))
+        pos += 2 + name_size
+    pos += -(pos - at) % 8
+
+    columns = {}
+    for kind, name in schema:
+        offset, _ = struct.unpack_from("<QQ", buffer, pos)
+        pos += 16
+        if kind == BATCH_F64:
+            columns[name] = np.frombuffer(buffer, "<f8", rows, at + offset)
+            continue
+        offsets = np.frombuffer(buffer, "<u4", rows + 1, at + offset)
+        text, _ = struct.unpack_from("<QQ", buffer, pos)
+        pos += 16
+        text = bytes(buffer[at + text:at + text + int(offsets[-1])])
+        columns[name] = [text[offsets[i]:offsets[i + 1]].decode() for i in range(rows)]
+    return columns
+
+def encode_frame(result):
+    return frame(0, encode_batch(result, ["day"]))
+
+def encode_result_frame(result, key_columns):
+    return frame(0, encode_batch(result, key_columns))
+
+def serve(fd):
+    """answers the viewer's queries until it hangs up, see src/cpp/python_worker.hpp"""
+    with socket.socket(fileno=fd) as connection, connection.makefile("rwb") as stream:
+        for line in stream:
+            try:
+                kind, n, group_by, aggregate, value, order_by, source = line.decode().rstrip("\n").split("\t")
+                if kind != "query":
+                    raise ValueError(f"unknown request '{kind}'")
+                data = dataset(source)
+                queried = time.perf_counter()
+                keys = group_by.split(",") if group_by else []
+                reply = encode_result_frame(run_query(data, int(n), keys, aggregate, value, order_by), keys)
+                print(f"python worker: query {time.perf_counter() - queried:.3f}s", file=sys.stderr)
+            except Exception as error:
+                reply = frame(IPC_FLAG_ERROR, str(error).encode())
+            stream.write(reply)
+            stream.flush()
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("n", type=int, nargs="?", default=100)
+    parser.add_argument("--ipc-fd", type=int, help="pipe the viewer reads the binary result from")
+    parser.add_argument("--serve-fd", type=int, help="socket to answer queries on until it closes")
+    args = parser.parse_args()
 
-    with open("tmp_DMPV_output.raw", "w") as k:
-        for i, row in enumerate(sorted_data2.itertuples(index=False) , start=1):
-            k.write(str(f"{row.day} {row.tip}\n"))
-    
+    if args.serve_fd is not None:
+        try:
+            serve(args.serve_fd)
+        except KeyboardInterrupt:
+            pass # ctrl-c in the viewer's terminal reaches us too
+        sys.exit(0)
 
-top_10_costliest_tips()
+    result = top_10_costliest_tips(args.n)
+    if args.ipc_fd is None:
+        for row in result.itertuples(index=False):
+            print(f"{row.day} {row.tip}")
+    else:
+        with os.fdopen(args.ipc_fd, "wb") as pipe:
+            pipe.write(encode_frame(result))
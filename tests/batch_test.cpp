@@ -0,0 +1,130 @@
+// the DMPB batch codec and the frames around it. with a path argument the
+// sample result is also written there as a frame, for test_main.py to read
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "check.hpp"
+#include "columnar.hpp"
+#include "ipc.hpp"
+
+namespace {
+
+group_result_t sample_result() {
+    group_result_t result;
+    result.key_columns = {"day", "time"};
+    result.value_columns = {"sum(tip)", "p99.5(tip)"};
+    result.keys = {{"Thursday", "Friday", ""}, {"Lunch", "Dinner, late", "\xc3\xa9t\xc3\xa9"}};
+    result.values = {{227.89, 0.1 + 0.2, -0.0}, {1e300, std::numeric_limits<double>::quiet_NaN(), 5}};
+    result.groups = 3;
+    return result;
+}
+
+bool same_values(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        // bit for bit, NaN included
+        if (!(a[i] == b[i] || (std::isnan(a[i]) && std::isnan(b[i])))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_result(const group_result_t& a, const group_result_t& b) {
+    if (a.key_columns != b.key_columns || a.value_columns != b.value_columns || a.keys != b.keys
+            || a.groups != b.groups || a.values.size() != b.values.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.values.size(); ++i) {
+        if (!same_values(a.values[i], b.values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_round_trip() {
+    group_result_t result = sample_result();
+    std::string batch = write_batch(result);
+    CHECK(batch.size() % batch_alignment == 0);
+
+    batch_view_t view;
+    std::string error;
+    CHECK(read_batch(batch, view, error));
+    CHECK(view.rows == 3);
+    CHECK(view.columns.size() == 4);
+    CHECK(same_result(batch_to_result(view), result));
+
+    // no groups at all still makes a readable batch
+    group_result_t empty;
+    empty.key_columns = {"day"};
+    empty.value_columns = {"sum(tip)"};
+    empty.keys.resize(1);
+    empty.values.resize(1);
+    std::string empty_batch = write_batch(empty);
+    CHECK(read_batch(empty_batch, view, error) && view.rows == 0);
+}
+
+void test_corrupt_batches() {
+    std::string batch = write_batch(sample_result());
+    batch_view_t view;
+    std::string error;
+
+    std::string bad_magic = batch;
+    bad_magic[0] = 'X';
+    CHECK(!read_batch(bad_magic, view, error));
+
+    CHECK(!read_batch(std::string_view(batch).substr(0, batch.size() - 8), view, error));
+    CHECK(!read_batch(std::string_view(batch).substr(0, 10), view, error));
+
+    // one byte in, so the batch isn't where an aligned read needs it
+    std::string shifted = " " + batch;
+    CHECK(!read_batch(std::string_view(shifted).substr(1), view, error));
+}
+
+void test_frames() {
+    group_result_t result = sample_result();
+    std::string frame = encode_result_frame(result);
+    CHECK(ipc_payload_size(frame) == frame.size() - ipc_header_size);
+
+    group_result_t decoded;
+    std::string error;
+    CHECK(decode_result_frame(frame, decoded, error));
+    CHECK(same_result(decoded, result));
+
+    // any flipped bit in the payload fails the checksum
+    for (std::size_t at : {ipc_header_size, frame.size() / 2, frame.size() - 1}) {
+        std::string flipped = frame;
+        flipped[at] ^= 0x10;
+        CHECK(!decode_result_frame(flipped, decoded, error));
+        CHECK(error == "checksum mismatch");
+    }
+
+    CHECK(!decode_result_frame(frame.substr(0, frame.size() - 1), decoded, error));
+    std::string wrong_version = frame;
+    wrong_version[4] = 9;
+    CHECK(!decode_result_frame(wrong_version, decoded, error));
+
+    // zlib's check value
+    CHECK(crc32("123456789") == 0xCBF43926);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    test_round_trip();
+    test_corrupt_batches();
+    test_frames();
+
+    if (argc > 1) {
+        std::string frame = encode_result_frame(sample_result());
+        std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        CHECK(out.good());
+    }
+    return check_result();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+// all the framework the tests need: CHECK() reports a failure and carries on,
+// main() returns check_result() so ctest sees a non-zero exit
+inline int check_failures = 0;
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++check_failures;                                                                 \
+        }                                                                                     \
+    } while (0)
+
+inline int check_result() {
+    if (check_failures) {
+        std::fprintf(stderr, "%d checks failed\n", check_failures);
+    }
+    return check_failures ? 1 : 0;
+}
+
+// a file in the temp directory holding data, removed when it goes out of scope
+class temp_file_t {
+public:
+    temp_file_t(std::string_view name, std::string_view data)
+            : path((std::filesystem::temp_directory_path() / ("dmpv-test-" + std::to_string(::getpid()) + "-" + std::string(name))).string()) {
+        write(data);
+    }
+    ~temp_file_t() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    temp_file_t(const temp_file_t&) = delete;
+    temp_file_t& operator=(const temp_file_t&) = delete;
+
+    void write(std::string_view data, bool append = false) const {
+        std::ofstream out(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    const std::string path;
+};
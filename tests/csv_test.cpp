@@ -0,0 +1,84 @@
+// csv_scanner and parse_decimal on the inputs real files throw at them
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "csv.hpp"
+#include "scan.hpp"
+
+namespace {
+
+// every record's fields, joined with | per record
+std::vector<std::string> scan_all(std::string_view data) {
+    std::vector<std::string> records;
+    csv_scanner scanner(data);
+    csv_scanner::record_t record;
+    while (scanner.next(record)) {
+        std::string joined;
+        for (std::size_t i = 0; i < record.count; ++i) {
+            if (i) {
+                joined += '|';
+            }
+            joined += record.fields[i];
+        }
+        records.push_back(joined);
+    }
+    return records;
+}
+
+void test_line_endings() {
+    using records_t = std::vector<std::string>;
+    CHECK(scan_all("a,b\n1,2\n") == (records_t{"a|b", "1|2"}));
+    CHECK(scan_all("a,b\r\n1,2\r\n") == (records_t{"a|b", "1|2"}));
+    // no newline after the last record
+    CHECK(scan_all("a,b\n1,2") == (records_t{"a|b", "1|2"}));
+    CHECK(scan_all("a,b\r\n1,2\r") == (records_t{"a|b", "1|2"}));
+    // blank lines are skipped, empty fields aren't
+    CHECK(scan_all("a,b\n\n1,\n\n,2\n") == (records_t{"a|b", "1|", "|2"}));
+    CHECK(scan_all("").empty());
+}
+
+void test_quotes() {
+    using records_t = std::vector<std::string>;
+    CHECK(scan_all("\"a,b\",c\n") == (records_t{"a,b|c"}));
+    // a quoted newline is part of the field, not the end of the record
+    CHECK(scan_all("x,\"1\n2\",y\r\nz,w\n") == (records_t{"x|1\n2|y", "z|w"}));
+    // a doubled quote stays doubled, nothing gets copied to unescape it
+    CHECK(scan_all("\"say \"\"hi\"\"\",1\n") == (records_t{"say \"\"hi\"\"|1"}));
+    // a quote that doesn't open the field is just a character
+    CHECK(scan_all("ab\"c,d\n") == (records_t{"ab\"c|d"}));
+    // never closed, the rest of the input is one field as written
+    CHECK(scan_all("\"unterminated,1\n2") == (records_t{"\"unterminated,1\n2"}));
+}
+
+void test_long_lines() {
+    // past a few 64 byte blocks, so every kernel's block walk gets used
+    std::string field(200, 'x');
+    std::string data = field + "," + field + "\n\"" + field + "\n" + field + "\"," + field;
+    auto records = scan_all(data);
+    CHECK(records.size() == 2);
+    CHECK(records.size() == 2 && records[1] == field + "\n" + field + "|" + field);
+}
+
+void test_decimals() {
+    double value = 0;
+    CHECK(parse_decimal("16.99", value) && value == 16.99);
+    CHECK(parse_decimal("-3", value) && value == -3);
+    CHECK(parse_decimal("0.5", value) && value == 0.5);
+    CHECK(parse_decimal("1e3", value) && value == 1000);
+    CHECK(parse_decimal("0.30000000000000004", value) && value == 0.30000000000000004);
+    CHECK(!parse_decimal("", value));
+    CHECK(!parse_decimal("abc", value));
+    CHECK(!parse_decimal("1.5x", value));
+}
+
+} // namespace
+
+int main() {
+    test_line_endings();
+    test_quotes();
+    test_long_lines();
+    test_decimals();
+    return check_result();
+}
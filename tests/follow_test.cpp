@@ -0,0 +1,81 @@
+// follow_tips() picking up appends, a line written in two halves and a file
+// that's replaced
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "check.hpp"
+#include "follow.hpp"
+
+namespace {
+
+// what the follower published last, waited on from the test's thread
+class published_t {
+public:
+    void publish(const tips_t& tips) {
+        std::lock_guard lock(mutex);
+        latest = tips;
+        ++count;
+        changed.notify_all();
+    }
+
+    // true once a published result satisfies done, false after a few seconds without one
+    bool wait_for(const std::function<bool(const tips_t&)>& done) {
+        std::unique_lock lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(5), [&] { return count > 0 && done(latest); });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    tips_t latest;
+    int count = 0;
+};
+
+void test_follow() {
+    temp_file_t file("follow.csv", "tip,day\n1,Sun\n2,Sat\n");
+
+    load_options_t options;
+    options.input = file.path;
+    options.top_n = 3;
+
+    published_t published;
+    std::jthread follower([&](std::stop_token stop) {
+        try {
+            follow_tips(options, nullptr, stop, [&](const tips_t& tips) { published.publish(tips); });
+        } catch (const load_error_t& e) {
+            std::fprintf(stderr, "%s\n", e.what());
+        }
+    });
+
+    CHECK(published.wait_for([](const tips_t& tips) { return tips[day_t::sunday] == 1 && tips[day_t::saturday] == 2; }));
+
+    // the third row fills the top 3, the fourth pushes the 1 out
+    file.write("3,Sun\n", true);
+    CHECK(published.wait_for([](const tips_t& tips) { return tips[day_t::sunday] == 4; }));
+    file.write("5,Fri\n", true);
+    CHECK(published.wait_for([](const tips_t& tips) {
+        return tips[day_t::sunday] == 3 && tips[day_t::saturday] == 2 && tips[day_t::friday] == 5;
+    }));
+
+    // half a line waits for the rest of it
+    file.write("7,Th", true);
+    file.write("ur\n", true);
+    CHECK(published.wait_for([](const tips_t& tips) { return tips[day_t::thursday] == 7 && !tips.has(day_t::saturday); }));
+
+    // replaced by a shorter file, which is read from the start
+    file.write("tip,day\n9,Sat\n");
+    CHECK(published.wait_for([](const tips_t& tips) { return tips.size() == 1 && tips[day_t::saturday] == 9; }));
+
+    follower.request_stop();
+}
+
+} // namespace
+
+int main() {
+    test_follow();
+    return check_result();
+}
@@ -0,0 +1,94 @@
+// queries through the table engine: aggregate parsing (pNN), the kernels and
+// key order
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "query.hpp"
+
+namespace {
+
+// tips 1 to 10, alternating between lunch and dinner (spelled a few ways)
+// and one brunch that isn't in the vocabulary
+constexpr std::string_view tips_csv =
+        "tip,time,day\n"
+        "1,Dinner,Sun\n2,Lunch,Sun\n3,Dinner,Sat\n4,Lunch,Sat\n5,Din,Thur\n"
+        "6,Lunch,Thursday\n7,Dinner,Fri\n8,Lunch,Fri\n9,Brunch,Sun\n10,Lunch,Sun\n";
+
+group_result_t query(const temp_file_t& file, std::vector<std::string> group_by, std::string aggregate) {
+    load_options_t options;
+    options.input = file.path;
+    options.top_n = 0;
+    options.group_by = std::move(group_by);
+    options.aggregate = std::move(aggregate);
+    options.use_cache = false;
+    return load_result(options);
+}
+
+// the single total of a query with no keys
+double total(const temp_file_t& file, const std::string& aggregate) {
+    group_result_t result = query(file, {}, aggregate);
+    return result.groups == 1 ? result.values[0][0] : std::nan("");
+}
+
+bool throws(const temp_file_t& file, const std::string& aggregate) {
+    try {
+        query(file, {}, aggregate);
+    } catch (const load_error_t&) {
+        return true;
+    }
+    return false;
+}
+
+bool near(double a, double b) {
+    return std::abs(a - b) < 1e-9;
+}
+
+void test_aggregates(const temp_file_t& file) {
+    CHECK(total(file, "sum") == 55);
+    CHECK(total(file, "mean") == 5.5);
+    CHECK(total(file, "count") == 10);
+    CHECK(total(file, "min") == 1);
+    CHECK(total(file, "max") == 10);
+
+    // linear interpolation between the closest ranks, like pandas' quantile()
+    CHECK(near(total(file, "p50"), 5.5));
+    CHECK(near(total(file, "p99.5"), 9.955));
+    CHECK(near(total(file, "p1e1"), 1.9));
+    CHECK(total(file, "p0") == 1);
+    CHECK(total(file, "p100") == 10);
+
+    for (const char *bad : {"p", "p101", "p-1", "pabc", "p50x", "p 50", "median"}) {
+        CHECK(throws(file, bad));
+    }
+}
+
+void test_key_order(const temp_file_t& file) {
+    // vocabulary order and spelled out, anything else after them
+    group_result_t time = query(file, {"time"}, "sum");
+    CHECK(time.keys.size() == 1 && time.keys[0] == (std::vector<std::string>{"Lunch", "Dinner", "Brunch"}));
+    CHECK(time.values.size() == 1 && time.values[0] == (std::vector<double>{30, 16, 9}));
+
+    group_result_t day = query(file, {"day"}, "count");
+    CHECK(day.keys.size() == 1 && day.keys[0] == (std::vector<std::string>{"Thursday", "Friday", "Saturday", "Sunday"}));
+    CHECK(day.values.size() == 1 && day.values[0] == (std::vector<double>{2, 2, 2, 4}));
+}
+
+void test_header_only() {
+    // no rows to tell the column types by, tip still sums (to nothing)
+    temp_file_t file("header-groupby.csv", "tip,time,day\n");
+    group_result_t result = query(file, {"time"}, "sum");
+    CHECK(result.groups == 0);
+    CHECK(result.value_columns == std::vector<std::string>{"sum(tip)"});
+}
+
+} // namespace
+
+int main() {
+    temp_file_t file("groupby.csv", tips_csv);
+    test_aggregates(file);
+    test_key_order(file);
+    test_header_only();
+    return check_result();
+}
@@ -0,0 +1,89 @@
+// get_tips_native() on awkward files, and the same answer for any thread count
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "check.hpp"
+#include "tips.hpp"
+
+namespace {
+
+tips_t load(const temp_file_t& file, std::size_t top_n, unsigned threads) {
+    load_options_t options;
+    options.input = file.path;
+    options.top_n = top_n;
+    options.threads = threads;
+    options.use_cache = false;
+    return get_tips_native(options, nullptr);
+}
+
+void test_small_files() {
+    temp_file_t crlf("crlf.csv", "total_bill,tip,day\r\n10,1.5,Thur\r\n20,2.25,Fri\r\n30,3,Thur\r\n");
+    tips_t tips = load(crlf, 0, 1);
+    CHECK(tips.size() == 2);
+    CHECK(tips[day_t::thursday] == 4.5);
+    CHECK(tips[day_t::friday] == 2.25);
+
+    // quoted fields with commas and newlines, and no newline at the very end
+    temp_file_t quoted("quoted.csv", "note,tip,day\n\"a, b\",1,Sun\n\"line\nSat,100\nline\",2,\"Sun\"\nx,4,Sat");
+    tips = load(quoted, 0, 1);
+    CHECK(tips.size() == 2);
+    CHECK(tips[day_t::sunday] == 3);
+    CHECK(tips[day_t::saturday] == 4);
+
+    // only the top 2 tips count
+    tips = load(quoted, 2, 1);
+    CHECK(tips[day_t::sunday] == 2);
+    CHECK(tips[day_t::saturday] == 4);
+
+    temp_file_t header_only("header.csv", "tip,day\n");
+    CHECK(load(header_only, 0, 1).empty());
+}
+
+void test_thread_counts() {
+    // a few MB so the file is cut into several chunks, with quoted newlines
+    // that look like rows sitting right where a naive cut would land
+    static constexpr const char *days[] = {"Thur", "Fri", "Sat", "Sun"};
+    std::mt19937 random(7);
+    std::string data = "note,tip,day\n";
+    std::int64_t cents[4] = {};
+    for (int row = 0; row < 400000; ++row) {
+        int day = static_cast<int>(random() % 4);
+        int tip = static_cast<int>(random() % 1000);
+        cents[day] += tip;
+        if (row % 3 == 0) {
+            data += "\"left\nSun,99999\nright, too\",";
+        } else {
+            data += "plain,";
+        }
+        data += std::to_string(tip / 100) + "." + (tip % 100 < 10 ? "0" : "") + std::to_string(tip % 100) + ","
+                + days[day] + (row % 5 == 0 ? "\r\n" : "\n");
+    }
+    temp_file_t file("threads.csv", data);
+
+    tips_t all = load(file, 0, 1);
+    for (int day = 0; day < 4; ++day) {
+        double expected = static_cast<double>(cents[day]) / 100;
+        CHECK(std::abs(all[static_cast<day_t>(day + 3)] - expected) < 1e-6);
+    }
+
+    tips_t top = load(file, 100, 1);
+    for (unsigned threads : {2u, 3u, 4u, 8u}) {
+        tips_t split = load(file, 0, threads);
+        tips_t split_top = load(file, 100, threads);
+        for (day_t day : all_days) {
+            CHECK(std::abs(split[day] - all[day]) < 1e-6);
+            // the same rows summed in the same order, to the bit
+            CHECK(split_top[day] == top[day]);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    test_small_files();
+    test_thread_counts();
+    return check_result();
+}
@@ -0,0 +1,72 @@
+"""src/py/main.py's side of the formats and queries the c++ tests cover.
+usage: test_main.py frame.bin, the frame batch_test wrote. exits 77 (a skip
+for ctest) without numpy and pandas"""
+import math
+import os
+import struct
+import sys
+import unittest
+import zlib
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "py"))
+try:
+    import pandas as pd
+    import main
+except ImportError as error:
+    print(f"test_main: skipped, {error}", file=sys.stderr)
+    sys.exit(77)
+
+FRAME_PATH = None
+
+class BatchTest(unittest.TestCase):
+    def test_reads_cpp_frame(self):
+        with open(FRAME_PATH, "rb") as file:
+            frame = file.read()
+        magic, _, flags, size, checksum = struct.unpack_from("<4sHHII", frame)
+        self.assertEqual((magic, flags, size), (main.IPC_MAGIC, 0, len(frame) - 16))
+        self.assertEqual(checksum, zlib.crc32(frame[16:]))
+
+        columns = main.read_batch(frame, 16)
+        self.assertEqual(list(columns), ["day", "time", "sum(tip)", "p99.5(tip)"])
+        self.assertEqual(columns["day"], ["Thursday", "Friday", ""])
+        self.assertEqual(columns["time"], ["Lunch", "Dinner, late", "été"])
+        self.assertEqual(list(columns["sum(tip)"]), [227.89, 0.1 + 0.2, 0.0])
+        self.assertEqual(columns["p99.5(tip)"][0], 1e300)
+        self.assertTrue(math.isnan(columns["p99.5(tip)"][1]))
+
+    def test_round_trip(self):
+        result = pd.DataFrame({"time": ["Lunch", "Dinner"], "size": [2.0, 3.5], "mean(tip)": [1.25, float("nan")]})
+        columns = main.read_batch(main.encode_batch(result, ["time", "size"]))
+        self.assertEqual(columns["time"], ["Lunch", "Dinner"])
+        self.assertEqual(columns["size"], ["2", "3.5"]) # integral keys print like the native ones
+        self.assertEqual(columns["mean(tip)"][0], 1.25)
+        self.assertTrue(math.isnan(columns["mean(tip)"][1]))
+
+        empty = main.read_batch(main.encode_batch(result.iloc[:0], ["time"]))
+        self.assertEqual(empty["time"], [])
+
+class QueryTest(unittest.TestCase):
+    def test_percentile(self):
+        # the same rules as make_kernel() in groupby.cpp, see groupby_test.cpp
+        self.assertEqual(main.percentile("p50"), 0.5)
+        self.assertEqual(main.percentile("p99.5"), 0.995)
+        self.assertEqual(main.percentile("p1e1"), 0.1)
+        self.assertEqual(main.percentile("p0"), 0)
+        self.assertEqual(main.percentile("p100"), 1)
+        for bad in ["p", "p101", "p-1", "pabc", "p50x", "p 50", "median", "pnan", "pinf"]:
+            self.assertIsNone(main.percentile(bad), bad)
+
+    def test_top_zero_is_every_row(self):
+        data = pd.DataFrame({"day": ["Sun", "Sat", "Sun"], "tip": [1.0, 2.0, 3.0]})
+        result = main.top_10_costliest_tips(0, data)
+        self.assertEqual(dict(zip(result["day"], result["tip"])), {"Sat": 2.0, "Sun": 4.0})
+
+    def test_category_order(self):
+        data = pd.DataFrame({"time": ["Dinner", "Lunch", "Brunch", "Din"], "tip": [1.0, 2.0, 3.0, 4.0]})
+        result = main.run_query(data, 0, ["time"], "sum", "tip", "tip")
+        self.assertEqual(list(result["time"]), ["Lunch", "Dinner", "Brunch"])
+        self.assertEqual(list(result["sum(tip)"]), [2.0, 5.0, 3.0])
+
+if __name__ == "__main__":
+    FRAME_PATH = sys.argv.pop(1)
+    unittest.main()
@@ -0,0 +1,73 @@
+// top_k with kept_before keeps what a stable sort by value would put first
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "tips.hpp"
+#include "top_k.hpp"
+
+namespace {
+
+struct row_t {
+    double value;
+    std::size_t index;
+};
+
+bool same_rows(const std::vector<row_t>& a, const std::vector<row_t>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+            [](const row_t& x, const row_t& y) { return x.value == y.value && x.index == y.index; });
+}
+
+// what pandas' nlargest(k, keep="first") keeps: a stable sort, biggest first
+std::vector<row_t> stable_top(std::vector<row_t> rows, std::size_t k) {
+    std::stable_sort(rows.begin(), rows.end(), [](const row_t& a, const row_t& b) { return a.value > b.value; });
+    rows.resize(std::min(k, rows.size()));
+    return rows;
+}
+
+void test_ties() {
+    // few distinct values, so nearly every comparison is a tie
+    std::mt19937 random(11);
+    std::vector<row_t> rows;
+    for (std::size_t i = 0; i < 5000; ++i) {
+        rows.push_back({static_cast<double>(random() % 7), i});
+    }
+
+    for (std::size_t k : {0, 1, 3, 100, 4999, 5000, 6000}) {
+        top_k<row_t, kept_before> top(k);
+        for (auto &row : rows) {
+            top.push(row);
+        }
+        CHECK(top.size() == std::min(k, rows.size()));
+        CHECK(same_rows(top.sorted(), stable_top(rows, k)));
+
+        // split between workers and merged, like the native loader does
+        top_k<row_t, kept_before> first(k);
+        top_k<row_t, kept_before> second(k);
+        for (auto &row : rows) {
+            (row.index % 3 ? first : second).push(row);
+        }
+        second.merge(first);
+        CHECK(same_rows(second.sorted(), stable_top(rows, k)));
+    }
+}
+
+void test_push_result() {
+    top_k<row_t, kept_before> top(2);
+    CHECK(top.push({1, 0}));
+    CHECK(top.push({2, 1}));
+    CHECK(top.full());
+    CHECK(!top.push({1, 2})); // ties with the worst but comes later
+    CHECK(top.push({3, 3}));
+    CHECK(top.worst().value == 2);
+}
+
+} // namespace
+
+int main() {
+    test_ties();
+    test_push_result();
+    return check_result();
+}